@@ -69,6 +69,8 @@ class BasicBlock : public Value, public llvm::ilist_node<BasicBlock> {
 
     /****************api about accessing parent****************/
     Function *get_parent() { return parent_; }
+    // 仅在把基本块整体移动到另一个函数时使用
+    void set_parent(Function *parent) { parent_ = parent; }
     Module *get_module();
     void erase_from_parent();
 
@@ -37,6 +37,8 @@ class Function : public Value, public llvm::ilist_node<Function> {
     Module *get_parent() const;
 
     void remove(BasicBlock *bb);
+    // 删除从入口不可达的基本块，返回是否有块被删除
+    bool remove_unreachable_bbs();
     BasicBlock *get_entry_block() { return &*basic_blocks_.begin(); }
 
     llvm::ilist<BasicBlock> &get_basic_blocks() { return basic_blocks_; }
@@ -49,7 +49,12 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
         getelementptr,
         zext, // zero extend
         fptosi,
-        sitofp
+        sitofp,
+        bitcast,
+        // Vector operators
+        extractelement,
+        insertelement,
+        shufflevector
         // float binary operators Logical operators
 
     };
@@ -100,6 +105,10 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
     bool is_call() const { return op_id_ == call; }
     bool is_gep() const { return op_id_ == getelementptr; }
     bool is_zext() const { return op_id_ == zext; }
+    bool is_bitcast() const { return op_id_ == bitcast; }
+    bool is_extractelement() const { return op_id_ == extractelement; }
+    bool is_insertelement() const { return op_id_ == insertelement; }
+    bool is_shufflevector() const { return op_id_ == shufflevector; }
 
     bool isBinary() const {
         return (is_add() || is_sub() || is_mul() || is_div() || is_fadd() ||
@@ -111,10 +120,15 @@ class Instruction : public User, public llvm::ilist_node<Instruction> {
 
     virtual Instruction *clone(BasicBlock *) const = 0;
 
+    // 分析过程中使用的标记位（如死代码消除中的活跃标记）
+    bool is_marked() const { return marked_; }
+    void set_marked(bool marked) { marked_ = marked; }
+
     OpID op_id_;
 
   private:
     BasicBlock *parent_;
+    bool marked_{false};
 };
 
 template <typename Inst> class BaseInst : public Instruction {
@@ -211,13 +225,7 @@ public:
 
     virtual std::string print() override;
     Function *func_;
-    Instruction *clone(BasicBlock *prt) const override {
-            if(get_operands().size() == 1){
-                return new CallInst(func_, {}, prt);
-            }
-        return new CallInst(
-            func_, {get_operands().begin() + 1, get_operands().end()}, prt);
-    }
+    Instruction *clone(BasicBlock *prt) const override;
 };
 
 class BranchInst : public BaseInst<BranchInst> {
@@ -375,6 +383,72 @@ class SiToFpInst : public BaseInst<SiToFpInst> {
     Instruction *clone(BasicBlock *prt) const override;
 };
 
+// 指针之间的类型转换，用于以向量类型访问数组元素
+class BitCastInst : public BaseInst<BitCastInst> {
+    friend BaseInst<BitCastInst>;
+
+  private:
+    BitCastInst(Value *val, Type *ty, BasicBlock *bb);
+
+  public:
+    static BitCastInst *create_bitcast(Value *val, Type *ty, BasicBlock *bb);
+
+    Type *get_dest_type() const { return get_type(); };
+
+    virtual std::string print() override;
+    Instruction *clone(BasicBlock *prt) const override;
+};
+
+class ExtractElementInst : public BaseInst<ExtractElementInst> {
+    friend BaseInst<ExtractElementInst>;
+
+  private:
+    ExtractElementInst(Value *vec, Value *idx, BasicBlock *bb);
+
+  public:
+    static ExtractElementInst *create_extractelement(Value *vec, Value *idx,
+                                                     BasicBlock *bb);
+
+    virtual std::string print() override;
+    Instruction *clone(BasicBlock *prt) const override;
+};
+
+class InsertElementInst : public BaseInst<InsertElementInst> {
+    friend BaseInst<InsertElementInst>;
+
+  private:
+    InsertElementInst(Value *vec, Value *elt, Value *idx, BasicBlock *bb);
+
+  public:
+    static InsertElementInst *create_insertelement(Value *vec, Value *elt,
+                                                   Value *idx, BasicBlock *bb);
+
+    virtual std::string print() override;
+    Instruction *clone(BasicBlock *prt) const override;
+};
+
+// 结果的第 i 个元素取两个输入拼接后的第 mask[i] 个元素
+class ShuffleVectorInst : public BaseInst<ShuffleVectorInst> {
+    friend BaseInst<ShuffleVectorInst>;
+
+  private:
+    ShuffleVectorInst(Value *v1, Value *v2, std::vector<int> mask,
+                      BasicBlock *bb);
+
+  public:
+    static ShuffleVectorInst *create_shufflevector(Value *v1, Value *v2,
+                                                   std::vector<int> mask,
+                                                   BasicBlock *bb);
+
+    const std::vector<int> &get_mask() const { return mask_; }
+
+    virtual std::string print() override;
+    Instruction *clone(BasicBlock *prt) const override;
+
+  private:
+    std::vector<int> mask_;
+};
+
 class PhiInst : public BaseInst<PhiInst> {
     friend BaseInst<PhiInst>;
 
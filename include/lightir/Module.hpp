@@ -30,6 +30,7 @@ class Module {
 
     PointerType *get_pointer_type(Type *contained);
     ArrayType *get_array_type(Type *contained, unsigned num_elements);
+    VectorType *get_vector_type(Type *contained, unsigned num_elements);
     FunctionType *get_function_type(Type *retty, std::vector<Type *> &args);
 
     void add_function(Function *f);
@@ -53,6 +54,7 @@ class Module {
     std::unique_ptr<FloatType> float32_ty_;
     std::map<Type *, std::unique_ptr<PointerType>> pointer_map_;
     std::map<std::pair<Type *, int>, std::unique_ptr<ArrayType>> array_map_;
+    std::map<std::pair<Type *, int>, std::unique_ptr<VectorType>> vector_map_;
     std::map<std::pair<Type *, std::vector<Type *>>,
              std::unique_ptr<FunctionType>>
         function_map_;
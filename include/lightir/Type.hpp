@@ -9,6 +9,7 @@ class FunctionType;
 class ArrayType;
 class PointerType;
 class FloatType;
+class VectorType;
 
 class Type {
   public:
@@ -19,7 +20,8 @@ class Type {
         FunctionTyID, // Functions
         ArrayTyID,    // Arrays
         PointerTyID,  // Pointer
-        FloatTyID     // float
+        FloatTyID,    // float
+        VectorTyID    // SIMD vector of int/float
     };
 
     explicit Type(TypeID tid, Module *m);
@@ -34,12 +36,14 @@ class Type {
     bool is_array_type() const { return get_type_id() == ArrayTyID; }
     bool is_pointer_type() const { return get_type_id() == PointerTyID; }
     bool is_float_type() const { return get_type_id() == FloatTyID; }
+    bool is_vector_type() const { return get_type_id() == VectorTyID; }
     bool is_int32_type() const;
     bool is_int1_type() const;
 
     // Return related data member if is the required type, else throw error
     Type *get_pointer_element_type() const;
     Type *get_array_element_type() const;
+    Type *get_vector_element_type() const;
 
     Module *get_module() const { return m_; }
     unsigned get_size() const;
@@ -109,6 +113,22 @@ class PointerType : public Type {
     Type *contained_; // The element type of the ptr.
 };
 
+class VectorType : public Type {
+  public:
+    VectorType(Type *contained, unsigned num_elements);
+
+    static bool is_valid_element_type(Type *ty);
+
+    static VectorType *get(Type *contained, unsigned num_elements);
+
+    Type *get_element_type() const { return contained_; }
+    unsigned get_num_of_elements() const { return num_elements_; }
+
+  private:
+    Type *contained_;
+    unsigned num_elements_;
+};
+
 class FloatType : public Type {
   public:
     FloatType(Module *m);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "PassManager.hpp"
+#include "RangeAnalysis.hpp"
+
+#include <memory>
+
+/**
+ * 删除冗余的下标检查：
+ * 数组访问前的 icmp sge idx, 0 与调用 neg_idx_except 的分支，
+ * 若取值范围分析能证明下标非负（常量、从 0 开始递增的循环变量、
+ * 已被支配处相同的检查或分支条件限定的值），改为直接跳到访问处
+ **/
+class BoundsCheckElim : public Pass {
+  public:
+    BoundsCheckElim(Module *m)
+        : Pass(m), range_(std::make_unique<RangeAnalysis>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<RangeAnalysis> range_;
+    int removed_count_{0};
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * 调用图分析：记录函数间的直接调用关系，
+ * 并按 Tarjan 算法求出强连通分量（自底向上，即被调用者先于调用者）
+ **/
+class CallGraph : public Pass {
+  public:
+    using FuncList = std::vector<Function *>;
+
+    explicit CallGraph(Module *m) : Pass(m) {}
+    ~CallGraph() = default;
+    void run() override;
+
+    // 函数直接调用的函数（按首次出现的顺序，不重复）
+    const FuncList &get_callees(Function *f) { return callees_.at(f); }
+    // 直接调用该函数的函数
+    const FuncList &get_callers(Function *f) { return callers_.at(f); }
+    // 调用该函数的所有调用点
+    const std::vector<CallInst *> &get_call_sites(Function *f) {
+        return call_sites_.at(f);
+    }
+
+    // 函数处于调用图的环上（含直接自递归）
+    bool is_recursive(Function *f) { return recursive_.count(f); }
+    bool in_same_scc(Function *f1, Function *f2) {
+        return scc_id_.at(f1) == scc_id_.at(f2);
+    }
+    // 强连通分量，被调用者所在的分量排在前面
+    const std::vector<FuncList> &get_sccs() { return sccs_; }
+
+    // 从 root 出发沿调用边可达的函数（包含 root）
+    std::set<Function *> get_reachable(Function *root);
+
+  private:
+    void tarjan(Function *f);
+
+    std::map<Function *, FuncList> callees_;
+    std::map<Function *, FuncList> callers_;
+    std::map<Function *, std::vector<CallInst *>> call_sites_;
+    std::set<Function *> recursive_;
+
+    std::vector<FuncList> sccs_;
+    std::map<Function *, int> scc_id_;
+
+    // Tarjan 算法的辅助状态
+    std::map<Function *, int> dfn_;
+    std::map<Function *, int> low_;
+    std::vector<Function *> stack_;
+    std::set<Function *> on_stack_;
+    int index_{0};
+};
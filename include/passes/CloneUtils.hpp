@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Module.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * 函数复制工具，供内联、函数特化等需要复制函数体的优化使用
+ **/
+
+// 把 src 的所有基本块复制到 dst 的末尾。调用前 v_map 中需给出 src
+// 参数到实参的映射；返回后 v_map 还包含 src 中每个基本块与指令到副本的映射。
+// 副本中的跳转只指向复制出的基本块，不影响 src 的前驱后继关系。
+// 给出 ret_target 时（内联），ret 被替换为跳转到 ret_target，
+// 返回值及其所在的副本块记录在 ret_vals 中
+std::vector<BasicBlock *>
+clone_blocks(Function *src, Function *dst, std::map<Value *, Value *> &v_map,
+             BasicBlock *ret_target = nullptr,
+             std::vector<std::pair<Value *, BasicBlock *>> *ret_vals = nullptr);
+
+// 在同一函数中复制一组基本块（如循环体）。组内的跳转指向副本，
+// 指向组外的跳转保持不变，组外后继中的 phi 需由调用者补充。
+// v_map 中预先给出映射的 phi 不复制，其使用被替换为映射值
+std::vector<BasicBlock *>
+clone_region(const std::vector<BasicBlock *> &bbs,
+             std::map<Value *, Value *> &v_map);
+
+// 以相同的签名复制整个函数
+Function *clone_function(Function *src, const std::string &name);
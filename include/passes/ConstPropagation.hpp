@@ -7,7 +7,8 @@
 #include "PassManager.hpp"
 #include "Value.hpp"
 
-#include <stack>
+#include <deque>
+#include <set>
 #include <unordered_map>
 #include <vector>
 ConstantFP *cast_constantfp(Value *value);
@@ -18,34 +19,71 @@ public:
     ConstFolder(Module *m) : module_(m) {}
     // cminus only support binary operations
     ConstantInt *compute(Instruction::OpID op, ConstantInt *value1, ConstantInt *value2);
-    ConstantFP *compute(Instruction::OpID op, ConstantFP *value1, ConstantFP *value2);
+    // 浮点比较的结果为 i1 常量
+    Constant *compute(Instruction::OpID op, ConstantFP *value1, ConstantFP *value2);
     // int -> float
     ConstantFP *compute(Instruction::OpID op, ConstantInt *value1);
     // float -> int
     ConstantInt *compute(Instruction::OpID op, ConstantFP *value1);
+    // 按指令类型折叠，ops 为各操作数对应的常量；无法折叠（如除零）时返回 nullptr
+    Constant *compute(Instruction *instr, const std::vector<Constant *> &ops);
 
 private:
     Module *module_;
 };
 
+/**
+ * 稀疏条件常量传播（Wegman-Zadeck SCCP）：
+ * 每个 SSA 值维护一个格值（未定 -> 常量 -> 非常量），并只沿可执行的控制流边传播，
+ * 收敛后把常量值替换到使用处、折叠已确定方向的分支并删除不可执行的基本块
+ **/
 class ConstPropagation : public Pass {
 public:
     ConstPropagation(Module *m) : Pass(m) {}
-    void run();
+    virtual ~ConstPropagation() = default;
+    void run() override;
 
-private:
-    // clear blocks recursively from the start_bb
-    void clear_blocks_recs(BasicBlock *start_bb);
+protected:
+    struct LatticeVal {
+        enum State { undef, constant, overdefined };
+        State state{undef};
+        Constant *value{nullptr};
+
+        bool is_undef() const { return state == undef; }
+        bool is_constant() const { return state == constant; }
+        bool is_overdefined() const { return state == overdefined; }
+    };
+
+    virtual LatticeVal get_lattice(Value *val);
+    // 把 val 的格值与 new_val 求交，格值变化时把使用者加入工作表
+    void merge_lattice(Value *val, LatticeVal new_val);
+    void mark_constant(Value *val, Constant *c);
+    void mark_overdefined(Value *val);
+    void mark_edge(BasicBlock *from, BasicBlock *to);
+    void mark_block(BasicBlock *bb);
+
+    // 以当前的可执行块与格值为起点迭代到不动点
+    void solve();
+    void visit(Instruction *instr);
+    void visit_phi(PhiInst *phi);
+    void visit_br(BranchInst *br);
+    void visit_expr(Instruction *instr);
+    // 过程内分析把调用结果视为非常量，过程间分析在此处沿调用边传播
+    virtual void visit_call(CallInst *call);
+    virtual void visit_ret(ReturnInst *ret) {}
+    // 分支条件收敛后仍为未定值时视为非常量，返回是否有修改
+    bool resolve_undef_branches(Function *func);
+
+    // 用求解结果改写函数，返回删除的指令数
+    int rewrite(Function *func);
 
-    // check if the bb is the entry block in func
-    bool is_entry(BasicBlock *bb);
-    IRBuilder *builder = new IRBuilder(nullptr, m_);
-    std::vector<Instruction *> wait_delete;
     ConstFolder *folder = new ConstFolder(m_);
-    // std::stack<GlobalVariable*>
-    std::unordered_map<GlobalVariable *, Constant *> globalvar_def;
-    // basic blocks that need to be removed
-    std::vector<BasicBlock *> delete_bb;
+    std::unordered_map<Value *, LatticeVal> lattice_;
+    std::set<BasicBlock *> executable_bbs_;
+    std::set<std::pair<BasicBlock *, BasicBlock *>> executable_edges_;
+    std::deque<BasicBlock *> bb_work_list_;
+    std::deque<Instruction *> instr_work_list_;
+    int folded_count_{0};
 };
 
 #endif
@@ -3,7 +3,9 @@
 #include "FuncInfo.hpp"
 #include "PassManager.hpp"
 
-#include <unordered_set>
+#include <deque>
+#include <memory>
+#include <vector>
 
 /**
  * 死代码消除：参见
@@ -15,16 +17,19 @@ class DeadCode : public Pass {
 
     void run();
 
+    // 增量删除：从给定指令出发，删除没有使用者且无副作用的指令，
+    // 并继续检查因此失去最后一个使用者的操作数。供删除指令的 pass 调用，
+    // 首次调用时计算函数的 mod/ref 信息
+    int erase_trivially_dead(std::vector<Instruction *> seeds);
+
   private:
     std::shared_ptr<FuncInfo> func_info;
+    bool func_info_ready{false};
     int ins_count{0}; // 用以衡量死代码消除的性能
     std::deque<Instruction *> work_list{};
-    std::unordered_map<Instruction *, bool> marked{};
 
     void mark(Function *func);
     void mark(Instruction *ins);
     bool sweep(Function *func);
-    bool clear_basic_blocks(Function *func);
     bool is_critical(Instruction *ins);
-    void sweep_globally();
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * 死存储消除：
+ * 内存模型中每个 alloca 和全局变量互不重叠，形如 gep base, 0, c 的地址视为精确位置。
+ * 逆向数据流计算每个程序点上“在被读取之前一定会被覆盖”的位置集合，
+ * 写入这些位置的 store 即为死存储。函数返回后局部变量失效，main 返回后全局变量也失效
+ **/
+class DeadStoreElimination : public Pass {
+  public:
+    DeadStoreElimination(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    // 内存位置：base 为 nullptr 表示基址未知，offset 为 -1 表示偏移未知
+    struct MemLoc {
+        Value *base;
+        int offset;
+    };
+    using State = std::vector<bool>;
+
+    Function *func_;
+    int erased_count_{0};
+    // 函数中被精确写入的位置及其编号
+    std::map<std::pair<Value *, int>, int> loc_id_;
+    std::vector<Value *> loc_base_;
+    // 地址被传出（如作为函数参数）的 alloca
+    std::set<Value *> escaped_;
+    // 从未被读取过的 alloca
+    std::set<Value *> unread_;
+    std::map<BasicBlock *, State> live_in_;
+
+    static MemLoc get_location(Value *ptr);
+    void collect_locations();
+    void analyze_base(Value *base);
+    bool may_be_read_by_call(Value *base) const;
+    State exit_state() const;
+    void transfer(Instruction *instr, State &state,
+                  std::vector<StoreInst *> *dead_stores);
+    void solve();
+    void run_on_function();
+};
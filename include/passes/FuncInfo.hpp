@@ -1,35 +1,70 @@
 #pragma once
 
+#include "CallGraph.hpp"
 #include "PassManager.hpp"
-#include "logging.hpp"
 
-#include <deque>
-#include <unordered_map>
+#include <map>
+#include <memory>
+#include <vector>
 
 /**
- * 计算哪些函数是纯函数
- * WARN:
- * 假定所有函数都是纯函数，除非他写入了全局变量、修改了传入的数组、或者直接间接调用了非纯函数
+ * 过程间 mod/ref 分析：
+ * 为每个函数计算一份访存摘要，包括是否读写全局变量、是否读写每个指针形参
+ * 指向的内存、是否进行 I/O。对局部变量（alloca）的读写不计入摘要。
+ * 按调用图的强连通分量自底向上计算，分量内迭代到不动点；
+ * 库函数 input、output 等视为 I/O；下标检查函数 neg_idx_except
+ * 不访问内存，但可能终止程序，单独记录
  */
 class FuncInfo : public Pass {
   public:
-    FuncInfo(Module *m) : Pass(m) {}
+    struct ModRef {
+        bool reads_global{false};
+        bool writes_global{false};
+        bool io{false};
+        // 可能因下标检查失败而终止程序
+        bool may_exit{false};
+        // 下标为形参序号，非指针形参恒为 false
+        std::vector<bool> reads_arg;
+        std::vector<bool> writes_arg;
 
-    void run();
+        bool operator==(const ModRef &other) const {
+            return reads_global == other.reads_global and
+                   writes_global == other.writes_global and
+                   io == other.io and may_exit == other.may_exit and
+                   reads_arg == other.reads_arg and
+                   writes_arg == other.writes_arg;
+        }
+        bool operator!=(const ModRef &other) const { return not(*this == other); }
+    };
 
-    bool is_pure_function(Function *func) const { return is_pure.at(func); }
+    FuncInfo(Module *m) : Pass(m), call_graph_(std::make_unique<CallGraph>(m)) {}
 
-  private:
-    std::deque<Function *> worklist;
-    std::unordered_map<Function *, bool> is_pure;
+    void run() override;
 
-    void trivial_mark(Function *func);
-    void process(Function *func);
-    Value *get_first_addr(Value *val);
+    const ModRef &get_mod_ref(Function *func) const {
+        return mod_ref_.at(func);
+    }
+    // 不读写任何非局部内存，也没有 I/O
+    bool is_readnone(Function *func) const;
+    // 只读内存，没有写入和 I/O
+    bool is_readonly(Function *func) const;
+    // 写内存、I/O 或可能终止程序，结果不被使用时也不能删除调用
+    bool has_side_effect(Function *func) const;
+    bool has_io(Function *func) const { return mod_ref_.at(func).io; }
+    bool reads_arg(Function *func, unsigned arg_no) const {
+        return mod_ref_.at(func).reads_arg.at(arg_no);
+    }
+    bool writes_arg(Function *func, unsigned arg_no) const {
+        return mod_ref_.at(func).writes_arg.at(arg_no);
+    }
 
-    bool is_side_effect_inst(Instruction *inst);
-    bool is_local_load(LoadInst *inst);
-    bool is_local_store(StoreInst *inst);
+  private:
+    std::unique_ptr<CallGraph> call_graph_;
+    std::map<Function *, ModRef> mod_ref_;
 
-    void log();
+    ModRef compute(Function *func);
+    // 把对 base 所指内存的一次读或写记入摘要
+    void add_access(ModRef &summary, Function *func, Value *base, bool write);
+    // 地址所指向的对象：alloca、全局变量或形参，无法确定时返回 nullptr
+    static Value *get_base(Value *addr);
 };
@@ -1,21 +1,58 @@
 #pragma once
 
+#include "CallGraph.hpp"
 #include "PassManager.hpp"
 
+#include <map>
+#include <memory>
 
-class FunctionInline : public Pass{
-public:
-    FunctionInline(Module *m) : Pass(m) {}
+/**
+ * 函数内联：
+ * 按调用图的强连通分量自底向上处理，被调函数先完成自身的内联；
+ * 同一分量内的（互相）递归调用不内联。
+ * 是否内联由被调函数的指令数估价决定：常量实参与唯一调用点可获得奖励，
+ * 每个调用者内联带来的指令增长不超过预算。
+ * 给出递归内联深度 k 时，自递归函数的递归调用点被展开 k 层，
+ * 同样受增长预算限制
+ **/
+class FunctionInline : public Pass {
+  public:
+    // 默认的估价阈值与调用者增长预算（指令数）
+    static constexpr int default_threshold = 40;
+    static constexpr int default_growth_budget = 400;
+    // 默认不展开递归调用
+    static constexpr int default_recursive_depth = 0;
 
-    void run();
+    FunctionInline(Module *m, int threshold = default_threshold,
+                   int growth_budget = default_growth_budget,
+                   int recursive_depth = default_recursive_depth)
+        : Pass(m), threshold_(threshold), growth_budget_(growth_budget),
+          recursive_depth_(recursive_depth),
+          call_graph_(std::make_unique<CallGraph>(m)) {}
 
-    void inline_function(Instruction *dest, Function *func);
+    void run() override;
 
-    void inline_all_functions();
+    // 把 call 处的调用替换为被调函数体的副本
+    void inline_function(CallInst *call, Function *func);
 
-    // void log();
-    std::set<std::string> outside_func={"output",
-                                        "outputFloat",
-                                        "input",
-                                        "neg_idx_except"};
-};
\ No newline at end of file
+  private:
+    int threshold_;
+    int growth_budget_;
+    int recursive_depth_;
+    std::unique_ptr<CallGraph> call_graph_;
+    // 每个调用者已经因内联增长的指令数
+    std::map<Function *, int> growth_;
+    int inline_count_{0};
+
+    void inline_calls_in(Function *caller);
+    // 把自递归函数的递归调用展开 recursive_depth_ 层
+    void inline_recursive(Function *func);
+    bool can_inline(CallInst *call, Function *callee);
+    // 没有返回点的递归函数无法展开
+    bool can_inline_recursive(Function *func);
+    // 被调函数的内联代价，已计入常量实参和唯一调用点的奖励
+    int get_cost(CallInst *call, Function *callee);
+    static int count_instructions(Function *func);
+    // 在 call 之后把基本块拆成两块，返回后半部分
+    BasicBlock *split_block_after(CallInst *call);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CallGraph.hpp"
+#include "DeadCode.hpp"
+#include "Dominators.hpp"
+#include "GlobalVariable.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * 全局变量常量传播：
+ * 从未被写入的全局变量（含数组）的读取替换为初值；
+ * 只在 main 中被写入一次常量、且所有读取都在该写入之后的标量全局变量，
+ * 其读取替换为写入的常量。
+ * 被替换的读取与不再使用的地址计算最后增量删除
+ **/
+class GlobalConstProp : public Pass {
+  public:
+    GlobalConstProp(Module *m)
+        : Pass(m), call_graph_(std::make_unique<CallGraph>(m)),
+          dce_(std::make_unique<DeadCode>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<CallGraph> call_graph_;
+    std::unique_ptr<Dominators> dominators_;
+    std::unique_ptr<DeadCode> dce_;
+    Function *main_func_{nullptr};
+    int replaced_count_{0};
+
+    // 收集全局变量上的 load/store，地址以其他方式使用时返回 false
+    bool collect_accesses(GlobalVariable *global,
+                          std::vector<LoadInst *> &loads,
+                          std::vector<StoreInst *> &stores);
+    Constant *get_zero(Type *ty);
+    // store 是否在 main 中先于 loads 的所有执行
+    bool store_precedes_loads(StoreInst *store,
+                              const std::vector<LoadInst *> &loads);
+    bool dominates(Instruction *def, Instruction *use);
+};
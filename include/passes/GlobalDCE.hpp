@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CallGraph.hpp"
+#include "GlobalVariable.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * 全局死代码消除：
+ * 删除从 main 沿调用图不可达的函数和没有被引用的全局变量，
+ * 并删除所有调用者都不使用的参数和返回值，同时改写调用点
+ **/
+class GlobalDCE : public Pass {
+  public:
+    GlobalDCE(Module *m)
+        : Pass(m), call_graph_(std::make_unique<CallGraph>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<CallGraph> call_graph_;
+    int func_count_{0};
+    int global_count_{0};
+    int arg_count_{0};
+    int ret_count_{0};
+
+    void remove_dead_functions();
+    void remove_dead_globals();
+    // 删除未使用的参数和返回值，返回是否修改了函数签名
+    bool shrink_signature(Function *func);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CallGraph.hpp"
+#include "GlobalVariable.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 全局变量局部化：
+ * 若标量全局变量只在一个不会重入的函数中被 load/store，
+ * 则用入口块中的 alloca 代替它，使 Mem2Reg 可以将其提升到寄存器。
+ * 对 main 直接用初值初始化；对其他函数在入口读入全局值，并在每个 ret 前写回
+ **/
+class GlobalLocalize : public Pass {
+  public:
+    GlobalLocalize(Module *m)
+        : Pass(m), call_graph_(std::make_unique<CallGraph>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<CallGraph> call_graph_;
+    int localized_count_{0};
+
+    // 返回唯一访问该全局变量的函数，不满足条件时返回 nullptr
+    Function *get_only_user(GlobalVariable *global);
+    void localize(GlobalVariable *global, Function *func);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CallGraph.hpp"
+#include "ConstPropagation.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 过程间稀疏条件常量传播（IPSCCP）：
+ * 从 main 出发求解整个模块，调用点的实参格值汇入被调函数的形参，
+ * 被调函数所有 ret 的格值汇入调用点的返回值。
+ * 开启函数特化时，先按调用点上互不相同的常量实参组合复制函数，
+ * 使各副本的形参在所有调用点上一致，从而被常量折叠
+ **/
+class IPConstPropagation : public ConstPropagation {
+  public:
+    IPConstPropagation(Module *m, bool specialize = false)
+        : ConstPropagation(m), specialize_(specialize),
+          call_graph_(std::make_unique<CallGraph>(m)) {}
+
+    void run() override;
+
+  private:
+    using SpecKey = std::vector<Constant *>;
+
+    // 每个函数最多的特化副本数
+    static constexpr int max_spec_per_func = 4;
+    // 特化复制的指令总数上限
+    static constexpr int spec_budget = 2000;
+
+    bool specialize_;
+    std::unique_ptr<CallGraph> call_graph_;
+    int spec_count_{0};
+    int spec_cost_{0};
+
+    LatticeVal get_lattice(Value *val) override;
+    void visit_call(CallInst *call) override;
+    void visit_ret(ReturnInst *ret) override;
+
+    void specialize_functions();
+    // 可以特化的参数位置：标量参数，且自递归调用原样传递该参数
+    std::vector<bool> get_spec_args(Function *func);
+    SpecKey get_spec_key(CallInst *call, const std::vector<bool> &spec_args);
+    Function *specialize(Function *func, const SpecKey &key);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "LoopInfo.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 归纳变量分析（要求循环已经过 LoopSimplify 规范化）：
+ * 基本归纳变量是循环头中形如 i = phi [init, preheader], [i + step, latch]
+ * 的整数 phi，其中 step 是循环不变量；
+ * 导出归纳变量是循环中可以表示为 scale * i + offset 的整数值，
+ * 其中 scale 为常量、offset 为循环不变量（或为空表示 0）
+ **/
+class InductionVars : public Pass {
+  public:
+    struct BasicIV {
+        PhiInst *phi;
+        Value *init;
+        Value *step;
+        Instruction *next;
+    };
+    struct AffineIV {
+        PhiInst *basic;
+        int scale;
+        Value *offset;
+    };
+
+    explicit InductionVars(Module *m)
+        : Pass(m), loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    // 分析模块中的所有循环
+    void run() override;
+    void run_on_loop(Loop *loop);
+
+    const std::vector<BasicIV> &get_basic_ivs(Loop *loop) {
+        return basic_ivs_[loop];
+    }
+    // 循环中每个可以表示为仿射形式的值（包括基本归纳变量本身）
+    const std::map<Value *, AffineIV> &get_affine_ivs(Loop *loop) {
+        return affine_ivs_[loop];
+    }
+
+    static bool is_invariant(Loop *loop, Value *val);
+
+  private:
+    std::unique_ptr<LoopInfo> loop_info_;
+    std::map<Loop *, std::vector<BasicIV>> basic_ivs_;
+    std::map<Loop *, std::map<Value *, AffineIV>> affine_ivs_;
+
+    // 由操作数的仿射形式推出 instr 的仿射形式
+    bool get_affine(Loop *loop, Instruction *instr, AffineIV &res);
+    // 两个循环不变量相加，只有一方为空或都为常量时才能直接得到结果
+    Value *add_offset(Value *lhs, Value *rhs);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ConstPropagation.hpp"
+#include "DeadCode.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 指令化简：
+ * 常量折叠加上代数恒等式（如 x+0、x*1、x*0、x-x、x/1、x==x），
+ * 结果总是已有的值或常量，不会创建新的指令。
+ * 被化简的指令及因此不再使用的操作数在工作表处理完后增量删除
+ **/
+
+// 返回与 instr 等价的已有值，无法化简时返回 nullptr。供其他 pass 按需调用
+Value *simplify_instruction(Instruction *instr, ConstFolder &folder);
+
+class InstSimplify : public Pass {
+  public:
+    InstSimplify(Module *m)
+        : Pass(m), folder_(m), dce_(std::make_unique<DeadCode>(m)) {}
+
+    void run() override;
+
+  private:
+    ConstFolder folder_;
+    std::unique_ptr<DeadCode> dce_;
+    int simplified_count_{0};
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Dominators.hpp"
+#include "FuncInfo.hpp"
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 循环不变量外提：
+ * 操作数都在循环外定义（或已外提）的算术、比较、类型转换、gep
+ * 以及不读写内存的函数调用被移到循环的前置块中。
+ * 可能出错或不返回的指令（整数除法、函数调用）只有位于循环头、
+ * 且之前没有调用时才外提，保证原本一定会在任何副作用或下标检查之前执行。
+ * 由内层循环向外处理，外提到内层前置块的指令可以继续被外层外提
+ **/
+class LICM : public Pass {
+  public:
+    LICM(Module *m)
+        : Pass(m), func_info_(std::make_unique<FuncInfo>(m)),
+          loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<FuncInfo> func_info_;
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    std::unique_ptr<Dominators> dominators_;
+    int hoisted_count_{0};
+
+    void run_on_loop(Loop *loop);
+    bool is_invariant(Loop *loop, Instruction *instr);
+    // 指令本身可以被移动（不考虑操作数）
+    bool can_hoist(Instruction *instr);
+    bool may_trap(Instruction *instr);
+    // 每次进入循环时 instr 一定在任何调用与下标检查之前执行
+    bool runs_first(Loop *loop, Instruction *instr);
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * 自然循环：由回边（目标支配源的边）确定，
+ * 同一循环头的多条回边合并为一个循环
+ **/
+class Loop {
+  public:
+    explicit Loop(BasicBlock *header) : header_(header) {}
+
+    BasicBlock *get_header() const { return header_; }
+    Loop *get_parent() const { return parent_; }
+    const std::vector<Loop *> &get_sub_loops() const { return sub_loops_; }
+    // 循环中的基本块，循环头在最前
+    const std::vector<BasicBlock *> &get_blocks() const { return blocks_; }
+    bool contains(BasicBlock *bb) const { return block_set_.count(bb); }
+    bool contains(const Loop *loop) const;
+    // 最外层循环的深度为 1
+    int get_depth() const;
+
+    // 循环内跳回循环头的基本块
+    std::vector<BasicBlock *> get_latches() const;
+    // 唯一的回边源，不唯一时返回 nullptr
+    BasicBlock *get_latch() const;
+    // 循环外唯一的前驱且只跳转到循环头，不存在时返回 nullptr
+    BasicBlock *get_preheader() const;
+    // 有后继在循环外的循环内基本块
+    std::vector<BasicBlock *> get_exiting_blocks() const;
+    // 循环外、有前驱在循环内的基本块
+    std::vector<BasicBlock *> get_exit_blocks() const;
+
+  private:
+    friend class LoopInfo;
+
+    BasicBlock *header_;
+    Loop *parent_{nullptr};
+    std::vector<Loop *> sub_loops_;
+    std::vector<BasicBlock *> blocks_;
+    std::set<BasicBlock *> block_set_;
+};
+
+/**
+ * 循环分析：基于支配树找出函数中的自然循环并建立嵌套关系。
+ * 要求函数中没有不可达基本块；控制流图改变后需要重新 run
+ **/
+class LoopInfo : public Pass {
+  public:
+    explicit LoopInfo(Module *m) : Pass(m) {}
+
+    void run() override;
+    void run_on_func(Function *func);
+
+    // 包含 bb 的最内层循环，不在循环中时返回 nullptr
+    Loop *get_loop_for(BasicBlock *bb) const {
+        auto it = bb_to_loop_.find(bb);
+        return it == bb_to_loop_.end() ? nullptr : it->second;
+    }
+    int get_loop_depth(BasicBlock *bb) const {
+        auto loop = get_loop_for(bb);
+        return loop == nullptr ? 0 : loop->get_depth();
+    }
+    bool is_loop_header(BasicBlock *bb) const {
+        auto loop = get_loop_for(bb);
+        return loop != nullptr and loop->get_header() == bb;
+    }
+    // 函数的最外层循环
+    const std::vector<Loop *> &get_top_loops(Function *func) {
+        return top_loops_[func];
+    }
+    // 函数的所有循环，内层循环排在外层之前
+    std::vector<Loop *> get_loops_inner_first(Function *func);
+
+  private:
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::map<BasicBlock *, Loop *> bb_to_loop_;
+    std::map<Function *, std::vector<Loop *>> top_loops_;
+
+    void clear_func(Function *func);
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 循环旋转：把 while 形式的循环改为带保护的 do-while 形式。
+ * 循环头中的判断被复制到前置块作为保护，并在 latch 中再复制一份，
+ * latch 直接以条件跳转回到循环体，每次迭代只执行一条跳转。
+ * 原循环头的 phi 移到循环体入口，循环外对它们的使用改用出口块中的 phi
+ **/
+class LoopRotate : public Pass {
+  public:
+    LoopRotate(Module *m)
+        : Pass(m), loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    int rotated_count_{0};
+
+    // 循环头只包含 phi、比较与条件跳转，且只有循环头退出
+    bool can_rotate(Loop *loop);
+    void rotate(Loop *loop);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "FuncInfo.hpp"
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+
+/**
+ * 循环内标量提升：
+ * 循环中只通过 load/store 访问的全局变量或数组的固定元素，
+ * 在前置块中读入一次，循环内改为读写一个临时局部变量，
+ * 并在每个出口写回一次；随后的 Mem2Reg 把临时变量提升为跨迭代的 phi。
+ * 同一对象有其他位置的访问、被调用的函数可能读写，或者循环中存在
+ * 无法确定对象的访存（可能指向任意数组）时，不提升该对象
+ **/
+class LoopScalarPromotion : public Pass {
+  public:
+    LoopScalarPromotion(Module *m)
+        : Pass(m), func_info_(std::make_unique<FuncInfo>(m)),
+          loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    void run() override;
+
+  private:
+    // 访存位置：对象（alloca 或全局变量）及元素下标，标量的下标为 0
+    using MemLoc = std::pair<Value *, int>;
+
+    std::unique_ptr<FuncInfo> func_info_;
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    int promoted_count_{0};
+
+    void run_on_loop(Loop *loop);
+    // 无法确定对象时返回 {nullptr, -1}，对象确定但位置不固定时下标为 -1
+    static MemLoc get_location(Value *ptr);
+    static bool is_array(Value *base);
+    void promote(Loop *loop, MemLoc loc, bool stored);
+};
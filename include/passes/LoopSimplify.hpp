@@ -0,0 +1,35 @@
+#pragma once
+
+#include "LoopInfo.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * 循环规范化，使每个循环满足：
+ * 1. 有唯一的前置块（preheader），它只跳转到循环头；
+ * 2. 只有一条回边（唯一的 latch）；
+ * 3. 所有出口块的前驱都在循环内（dedicated exit）。
+ * 新插入的块在原块中 phi 的对应位置合并传入值，循环优化在此基础上进行
+ **/
+class LoopSimplify : public Pass {
+  public:
+    LoopSimplify(Module *m)
+        : Pass(m), loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    void run() override;
+    // 规范化单个函数，返回是否修改了控制流图
+    bool run_on_func(Function *func);
+
+    // 在 bb 与 preds 之间插入新块：preds 改为跳到新块，新块跳到 bb
+    static BasicBlock *split_predecessors(BasicBlock *bb,
+                                          const std::vector<BasicBlock *> &preds);
+
+  private:
+    std::unique_ptr<LoopInfo> loop_info_;
+    int inserted_count_{0};
+
+    // 对一个循环做一步规范化，修改了控制流图时返回 true
+    bool simplify_loop(Loop *loop);
+};
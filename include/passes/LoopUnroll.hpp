@@ -0,0 +1,68 @@
+#pragma once
+
+#include "InductionVars.hpp"
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+
+/**
+ * 循环展开，只处理最内层、只在循环头退出的循环，
+ * 即 while (i < n) { ...; i = i + c; } 这样的形式：
+ * 初值与上界都是常量且迭代次数较少时完全展开，去掉循环；
+ * 否则按 unroll_count 部分展开：主循环每 unroll_count 次迭代只判断一次
+ * i < n - (unroll_count - 1) * c，剩余的迭代由原循环完成
+ **/
+class LoopUnroll : public Pass {
+  public:
+    static constexpr int default_unroll_count = 4;
+    // 完全展开的最大迭代次数
+    static constexpr int max_full_trip_count = 64;
+    // 展开后循环体的指令数上限
+    static constexpr int full_unroll_budget = 256;
+    static constexpr int partial_unroll_budget = 256;
+
+    LoopUnroll(Module *m, int unroll_count = default_unroll_count)
+        : Pass(m), unroll_count_(unroll_count),
+          loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)),
+          ivs_(std::make_unique<InductionVars>(m)) {}
+
+    void run() override;
+
+  private:
+    // 循环头中的退出判断，已整理为“pred(iv, bound) 成立时继续循环”
+    struct ExitCond {
+        PhiInst *iv;
+        Value *init;
+        int step;
+        Instruction::OpID pred;
+        Value *bound;
+        BasicBlock *body;
+        BasicBlock *exit;
+    };
+
+    int unroll_count_;
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    std::unique_ptr<InductionVars> ivs_;
+    int full_count_{0};
+    int partial_count_{0};
+
+    bool analyze(Loop *loop, ExitCond &cond);
+    // 迭代次数未知或超过 max_full_trip_count 时返回 -1
+    int get_trip_count(const ExitCond &cond);
+    static int count_instructions(Loop *loop);
+
+    void full_unroll(Loop *loop, const ExitCond &cond, int trip_count);
+    void partial_unroll(Loop *loop, const ExitCond &cond, int factor);
+    // 复制一次迭代，循环头的 phi 取 vals 中的值。
+    // 返回副本循环体的入口与 latch，vals 更新为下一次迭代的 phi 值
+    std::pair<BasicBlock *, BasicBlock *>
+    clone_iteration(Loop *loop, const ExitCond &cond,
+                    std::map<PhiInst *, Value *> &vals);
+    // 把 bb 的跳转改为无条件跳转到 target
+    static void retarget(BasicBlock *bb, BasicBlock *target);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 最内层循环向量化，处理 while (i < n) { ...; i = i + 1; } 形式、
+ * 循环体为一条直线路径的循环：
+ * 访存只能是循环不变的数组基址以 i 为下标的 a[i]，
+ * 数组参数只能传入整个数组，不同基址要么相同要么不重叠，
+ * 因此不同迭代访问的元素互不相同，不存在跨迭代的依赖；
+ * 其余指令只能是以这些值或循环不变量为操作数的算术运算。
+ * 除 i 外的循环头 phi 只能是整数加法归约 s = s + x。
+ * 向量循环每次处理 vector_width 次迭代，剩余迭代由原循环完成。
+ * 浮点加法归约会改变舍入结果，不做向量化
+ **/
+class LoopVectorize : public Pass {
+  public:
+    static constexpr int vector_width = 4;
+
+    LoopVectorize(Module *m)
+        : Pass(m), loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)) {}
+
+    void run() override;
+
+  private:
+    // s = phi [init, preheader], [s + operand, latch]
+    struct Reduction {
+        PhiInst *phi;
+        Value *init;
+        Instruction *update;
+        Value *operand;
+    };
+    struct Plan {
+        PhiInst *iv{nullptr};
+        Value *init{nullptr};
+        Instruction *next{nullptr};
+        Value *bound{nullptr};
+        BasicBlock *exit{nullptr};
+        std::vector<Reduction> reductions;
+        // 循环体中按执行顺序排列的指令（不含跳转）
+        std::vector<Instruction *> body;
+    };
+
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    int vectorized_count_{0};
+
+    bool analyze(Loop *loop, Plan &plan);
+    // 收集循环体的直线路径
+    bool collect_body(Loop *loop, BasicBlock *entry, Plan &plan);
+    bool find_reductions(Loop *loop, Plan &plan);
+    bool check_body(Loop *loop, const Plan &plan);
+    // base[i] 或 base[0][i] 形式的元素地址
+    bool is_unit_stride_gep(Loop *loop, PhiInst *iv, Instruction *instr);
+    void vectorize(Loop *loop, const Plan &plan);
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "InductionVars.hpp"
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+#include "RangeAnalysis.hpp"
+
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * 循环版本化，外提无法静态消除的下标检查：
+ * 对最内层、只在循环头退出的循环，若其中检查的下标是循环不变量
+ * 或随迭代单调不减的仿射归纳变量 scale * i + offset，
+ * 进入循环前计算所有迭代中的最小下标 scale * init + offset，
+ * 都不为负时进入去掉这些检查的副本，否则执行保留全部
+ * neg_idx_except 调用的原循环。
+ * 取值范围分析用于保证下标与最小值的计算都不会溢出
+ **/
+class LoopVersioning : public Pass {
+  public:
+    // 被复制的循环的指令数上限
+    static constexpr int version_budget = 256;
+
+    LoopVersioning(Module *m)
+        : Pass(m), loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)),
+          ivs_(std::make_unique<InductionVars>(m)),
+          range_(std::make_unique<RangeAnalysis>(m)) {}
+
+    void run() override;
+
+  private:
+    // 可以在进入循环前判断的检查，最小下标为 scale * base + offset
+    struct Check {
+        Instruction *br;
+        BasicBlock *target;
+        Value *base;
+        int scale;
+        Value *offset;
+    };
+
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    std::unique_ptr<InductionVars> ivs_;
+    std::unique_ptr<RangeAnalysis> range_;
+    // 已处理过的循环头，包括版本化产生的副本
+    std::set<BasicBlock *> visited_;
+    int versioned_count_{0};
+
+    bool analyze(Loop *loop, std::vector<Check> &checks);
+    bool get_check(Loop *loop, BasicBlock *bb, Check &check);
+    void version(Loop *loop, const std::vector<Check> &checks);
+};
@@ -6,6 +6,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 
 class Mem2Reg : public Pass {
   private:
@@ -18,6 +19,15 @@ class Mem2Reg : public Pass {
     std::map<Value *, std::vector<Value *>> var_val_stack;
     // phi指令对应的左值(地址)
     std::map<PhiInst *, Value *> phi_lval;
+    // 统计插入与移除的 phi 数量
+    int phi_count_{0};
+    int trivial_phi_count_{0};
+
+    // 变量活跃进入的块集合，用于剪枝 phi 的放置
+    std::set<BasicBlock *>
+    compute_live_in(Value *var, const std::set<BasicBlock *> &use_blocks,
+                    const std::set<BasicBlock *> &def_blocks);
+    void remove_trivial_phi();
 
   public:
     Mem2Reg(Module *m) : Pass(m) {}
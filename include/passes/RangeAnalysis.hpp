@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Dominators.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 整数取值范围分析：在 SSA 上为每个 i32 值计算区间 [lo, hi]。
+ * 使用某个值时结合支配该处的分支条件收紧区间，
+ * phi 的每个输入按所在的边收紧，因此 while (i < n) 中的 i 有上界。
+ * 循环中的 phi 多次增长后加宽到比较中出现的常量附近或整数边界，
+ * 保证迭代终止；运算可能溢出时结果视为任意值。
+ * 调用 neg_idx_except 的块不会继续执行，从它进入的边不参与计算
+ **/
+class RangeAnalysis : public Pass {
+  public:
+    struct Range {
+        int64_t lo;
+        int64_t hi;
+
+        static Range full() { return {INT_MIN, INT_MAX}; }
+        static Range empty() { return {1, 0}; }
+        static Range point(int64_t val) { return {val, val}; }
+        bool is_empty() const { return lo > hi; }
+        bool operator==(const Range &rhs) const {
+            return (is_empty() and rhs.is_empty()) or
+                   (lo == rhs.lo and hi == rhs.hi);
+        }
+        bool operator!=(const Range &rhs) const { return not(*this == rhs); }
+        Range join(const Range &rhs) const;
+        Range meet(const Range &rhs) const;
+    };
+
+    explicit RangeAnalysis(Module *m) : Pass(m) {}
+
+    void run() override;
+    // 结果只保留最近一次分析的函数
+    void run_on_func(Function *func);
+
+    Range get_range(Value *val);
+    // val 在 bb 中使用时的取值范围
+    Range get_range(Value *val, BasicBlock *bb);
+    // 比较结果在 bb 中是否恒定，恒定时写入 res
+    bool eval_cmp(Instruction *cmp, BasicBlock *bb, bool &res);
+
+    static bool is_trap_block(BasicBlock *bb);
+
+  private:
+    // 已知比较结果为 second 的比较指令
+    using CondList = std::vector<std::pair<Instruction *, bool>>;
+
+    std::unique_ptr<Dominators> dominators_;
+    std::map<Value *, Range> ranges_;
+    std::map<BasicBlock *, CondList> conds_;
+    std::map<Value *, int> update_count_;
+    std::vector<int64_t> thresholds_;
+
+    void collect_conds(Function *func);
+    void collect_thresholds(Function *func);
+    // 从 pred 跳到 succ 时已知的条件
+    bool get_edge_cond(BasicBlock *pred, BasicBlock *succ,
+                       std::pair<Instruction *, bool> &cond);
+    Range refine(Value *val, Range range, const CondList &conds);
+    Range eval(Instruction *instr);
+    Range widen(const Range &old_range, const Range &new_range);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+
+/**
+ * 局部数组的标量替换：
+ * 若数组的所有访问都是形如 gep base, 0, c 的常量下标访问，且没有逃逸到函数调用，
+ * 则把数组拆分为逐元素的标量 alloca，交由 Mem2Reg 提升到寄存器
+ **/
+class SROA : public Pass {
+  public:
+    SROA(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    Function *func_;
+    int split_count_{0};
+
+    bool can_split(AllocaInst *alloca);
+    void split(AllocaInst *alloca);
+    // 取出 gep base, 0, c 中的常量下标 c，不满足该形式时返回 -1
+    static int get_const_index(GetElementPtrInst *gep);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+/**
+ * 控制流图化简：
+ * 折叠条件为常量的条件跳转，删除不可达基本块，
+ * 把只有一个前驱（且该前驱只有一个后继）的基本块合并进前驱，
+ * 并把只包含一条无条件跳转的空基本块旁路掉，过程中保持 phi 一致
+ **/
+class SimplifyCFG : public Pass {
+  public:
+    SimplifyCFG(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    Function *func_;
+    int folded_count_{0};
+    int merged_count_{0};
+    int forwarded_count_{0};
+
+    bool fold_branches();
+    bool merge_blocks();
+    bool forward_empty_blocks();
+
+    // 把 bb 的条件跳转替换为到 target 的无条件跳转
+    void replace_with_br(BasicBlock *bb, BasicBlock *target);
+    // 把 bb 合并进唯一的前驱 pre
+    void merge_into(BasicBlock *bb, BasicBlock *pre);
+    // 判断空块 bb 能否被旁路到其唯一后继
+    bool can_forward(BasicBlock *bb);
+    void forward(BasicBlock *bb);
+};
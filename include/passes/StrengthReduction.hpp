@@ -0,0 +1,37 @@
+#pragma once
+
+#include "InductionVars.hpp"
+#include "LoopInfo.hpp"
+#include "LoopSimplify.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 循环强度削弱：
+ * 把循环中对归纳变量的乘法 scale * i + offset 替换为新的归纳变量，
+ * 在前置块中计算初值，每次迭代在 latch 中加上 scale * step；
+ * 初值与步长都相同的基本归纳变量合并为一个
+ **/
+class StrengthReduction : public Pass {
+  public:
+    StrengthReduction(Module *m)
+        : Pass(m), loop_simplify_(std::make_unique<LoopSimplify>(m)),
+          loop_info_(std::make_unique<LoopInfo>(m)),
+          ivs_(std::make_unique<InductionVars>(m)) {}
+
+    void run() override;
+
+  private:
+    std::unique_ptr<LoopSimplify> loop_simplify_;
+    std::unique_ptr<LoopInfo> loop_info_;
+    std::unique_ptr<InductionVars> ivs_;
+    int reduced_count_{0};
+    int merged_count_{0};
+
+    void reduce_multiplies(Loop *loop);
+    void merge_redundant_ivs(Loop *loop);
+    // 在 bb 的跳转指令之前计算 lhs * rhs 或 lhs + rhs，常量直接折叠
+    Value *emit_mul(Value *lhs, int rhs, BasicBlock *bb);
+    Value *emit_add(Value *lhs, Value *rhs, BasicBlock *bb);
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <vector>
+
+/**
+ * 尾递归消除：
+ * 把自递归的尾调用改为跳回函数开头的循环，形参由循环头中的 phi 给出。
+ * 形如 return x + f(...) 或 return x * f(...) 的调用通过引入累加器也改为循环：
+ * 累加器初值为运算的单位元，每次跳回前与 x 运算，非递归的返回值最后再与累加器运算
+ **/
+class TailRecursionElim : public Pass {
+  public:
+    TailRecursionElim(Module *m) : Pass(m) {}
+
+    void run() override;
+
+  private:
+    // 函数末尾的递归调用点
+    struct TailCall {
+        CallInst *call;
+        // 累加运算，普通尾调用时为 nullptr
+        Instruction *acc_op;
+    };
+
+    int eliminated_count_{0};
+
+    // 局部变量的地址被传入调用时，递归调用仍需要独立的栈帧
+    bool has_escaping_alloca(Function *func);
+    bool match_tail_call(BasicBlock *bb, Function *func, TailCall &tail);
+    void eliminate(Function *func, std::vector<TailCall> &tails);
+};
@@ -8,6 +8,24 @@
 #include "Mem2Reg.hpp"
 #include "ConstPropagation.hpp"
 #include "FunctionInline.hpp"
+#include "SROA.hpp"
+#include "GlobalLocalize.hpp"
+#include "DeadStoreElimination.hpp"
+#include "GlobalDCE.hpp"
+#include "SimplifyCFG.hpp"
+#include "IPConstPropagation.hpp"
+#include "InstSimplify.hpp"
+#include "GlobalConstProp.hpp"
+#include "TailRecursionElim.hpp"
+#include "LoopSimplify.hpp"
+#include "LICM.hpp"
+#include "LoopScalarPromotion.hpp"
+#include "StrengthReduction.hpp"
+#include "LoopUnroll.hpp"
+#include "LoopRotate.hpp"
+#include "BoundsCheckElim.hpp"
+#include "LoopVersioning.hpp"
+#include "LoopVectorize.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -28,6 +46,29 @@ struct Config {
     bool const_prop{false};
     bool dce{false};
     bool func_inline{false};
+    bool sroa{false};
+    bool global_localize{false};
+    bool dse{false};
+    bool global_dce{false};
+    bool simplify_cfg{false};
+    bool ipsccp{false};
+    bool func_spec{false};
+    bool inst_simplify{false};
+    bool global_const_prop{false};
+    bool tre{false};
+    bool loop_simplify{false};
+    bool licm{false};
+    bool loop_promote{false};
+    bool strength_reduce{false};
+    bool loop_unroll{false};
+    bool loop_rotate{false};
+    bool bce{false};
+    bool loop_version{false};
+    bool loop_vectorize{false};
+    int inline_threshold{FunctionInline::default_threshold};
+    int inline_budget{FunctionInline::default_growth_budget};
+    int inline_depth{FunctionInline::default_recursive_depth};
+    int unroll_count{LoopUnroll::default_unroll_count};
 
     Config(int argc, char **argv) : argc(argc), argv(argv) {
         parse_cmd_line();
@@ -63,12 +104,33 @@ int main(int argc, char **argv) {
         PassManager PM(m.get());
         // optimization 
         if(config.dce) {
+            if(config.global_localize) {
+                PM.add_pass<GlobalLocalize>();
+            }
+            if(config.sroa) {
+                PM.add_pass<SROA>();
+            }
             PM.add_pass<Mem2Reg>();
+            if(config.dse) {
+                PM.add_pass<DeadStoreElimination>();
+            }
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.global_const_prop) {
+            PM.add_pass<GlobalConstProp>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.tre) {
+            PM.add_pass<TailRecursionElim>();
             PM.add_pass<DeadCode>();
         }
 
         if(config.func_inline) {
-            PM.add_pass<FunctionInline>();
+            PM.add_pass<FunctionInline>(config.inline_threshold,
+                                        config.inline_budget,
+                                        config.inline_depth);
             PM.add_pass<DeadCode>();
         }
 
@@ -78,6 +140,72 @@ int main(int argc, char **argv) {
             PM.add_pass<ConstPropagation>();
             PM.add_pass<DeadCode>();
         }
+
+        if(config.inst_simplify) {
+            PM.add_pass<InstSimplify>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.ipsccp) {
+            PM.add_pass<IPConstPropagation>(config.func_spec);
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.simplify_cfg) {
+            PM.add_pass<SimplifyCFG>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.bce) {
+            PM.add_pass<BoundsCheckElim>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_simplify) {
+            PM.add_pass<LoopSimplify>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.licm) {
+            PM.add_pass<LICM>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_promote) {
+            PM.add_pass<LoopScalarPromotion>();
+            PM.add_pass<Mem2Reg>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.strength_reduce) {
+            PM.add_pass<StrengthReduction>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_version) {
+            PM.add_pass<LoopVersioning>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_vectorize) {
+            PM.add_pass<LoopVectorize>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_unroll) {
+            PM.add_pass<LoopUnroll>(config.unroll_count);
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.loop_rotate) {
+            PM.add_pass<LoopRotate>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if(config.global_dce) {
+            PM.add_pass<GlobalDCE>();
+            PM.add_pass<DeadCode>();
+        }
         PM.run();
 
         std::ofstream output_stream(config.output_file);
@@ -114,6 +242,67 @@ void Config::parse_cmd_line() {
             const_prop = true;
         } else if (argv[i] == "-func-inline"s) {
             func_inline = true;
+        } else if (argv[i] == "-sroa"s) {
+            sroa = true;
+        } else if (argv[i] == "-global-localize"s) {
+            global_localize = true;
+        } else if (argv[i] == "-dse"s) {
+            dse = true;
+        } else if (argv[i] == "-global-dce"s) {
+            global_dce = true;
+        } else if (argv[i] == "-simplify-cfg"s) {
+            simplify_cfg = true;
+        } else if (argv[i] == "-ipsccp"s) {
+            ipsccp = true;
+        } else if (argv[i] == "-func-spec"s) {
+            func_spec = true;
+        } else if (argv[i] == "-inst-simplify"s) {
+            inst_simplify = true;
+        } else if (argv[i] == "-global-const-prop"s) {
+            global_const_prop = true;
+        } else if (argv[i] == "-tre"s) {
+            tre = true;
+        } else if (argv[i] == "-loop-simplify"s) {
+            loop_simplify = true;
+        } else if (argv[i] == "-licm"s) {
+            licm = true;
+        } else if (argv[i] == "-loop-promote"s) {
+            loop_promote = true;
+        } else if (argv[i] == "-strength-reduce"s) {
+            strength_reduce = true;
+        } else if (argv[i] == "-loop-unroll"s) {
+            loop_unroll = true;
+        } else if (argv[i] == "-loop-rotate"s) {
+            loop_rotate = true;
+        } else if (argv[i] == "-bce"s) {
+            bce = true;
+        } else if (argv[i] == "-loop-version"s) {
+            loop_version = true;
+        } else if (argv[i] == "-loop-vectorize"s) {
+            loop_vectorize = true;
+        } else if (argv[i] == "-inline-threshold"s ||
+                   argv[i] == "-inline-budget"s ||
+                   argv[i] == "-inline-depth"s ||
+                   argv[i] == "-unroll-count"s) {
+            if (i + 1 >= argc) {
+                print_err("missing value for "s + argv[i]);
+            }
+            int value = 0;
+            try {
+                value = std::stoi(argv[i + 1]);
+            } catch (const std::exception &) {
+                print_err("bad value for "s + argv[i]);
+            }
+            if (argv[i] == "-inline-threshold"s) {
+                inline_threshold = value;
+            } else if (argv[i] == "-inline-budget"s) {
+                inline_budget = value;
+            } else if (argv[i] == "-inline-depth"s) {
+                inline_depth = value;
+            } else {
+                unroll_count = value;
+            }
+            i += 1;
         } else {
             if (input_file.empty()) {
                 input_file = argv[i];
@@ -139,6 +328,63 @@ void Config::check() {
     if (func_inline && not dce) {
         print_err("function inline pass need dce pass");
     }
+    if (sroa && not dce) {
+        print_err("sroa pass need dce pass");
+    }
+    if (global_localize && not dce) {
+        print_err("global localize pass need dce pass");
+    }
+    if (dse && not dce) {
+        print_err("dead store elimination pass need dce pass");
+    }
+    if (global_dce && not dce) {
+        print_err("global dce pass need dce pass");
+    }
+    if (simplify_cfg && not dce) {
+        print_err("simplify cfg pass need dce pass");
+    }
+    if (ipsccp && not dce) {
+        print_err("ipsccp pass need dce pass");
+    }
+    if (func_spec && not ipsccp) {
+        print_err("function specialization need ipsccp pass");
+    }
+    if (inst_simplify && not dce) {
+        print_err("inst simplify pass need dce pass");
+    }
+    if (global_const_prop && not dce) {
+        print_err("global const prop pass need dce pass");
+    }
+    if (tre && not dce) {
+        print_err("tail recursion elimination pass need dce pass");
+    }
+    if (loop_simplify && not dce) {
+        print_err("loop simplify pass need dce pass");
+    }
+    if (licm && not dce) {
+        print_err("licm pass need dce pass");
+    }
+    if (loop_promote && not dce) {
+        print_err("loop scalar promotion pass need dce pass");
+    }
+    if (strength_reduce && not dce) {
+        print_err("strength reduction pass need dce pass");
+    }
+    if (loop_unroll && not dce) {
+        print_err("loop unroll pass need dce pass");
+    }
+    if (loop_rotate && not dce) {
+        print_err("loop rotate pass need dce pass");
+    }
+    if (bce && not dce) {
+        print_err("bounds check elim pass need dce pass");
+    }
+    if (loop_version && not dce) {
+        print_err("loop versioning pass need dce pass");
+    }
+    if (loop_vectorize && not dce) {
+        print_err("loop vectorize pass need dce pass");
+    }
     if (output_file.empty()) {
         output_file = input_file.stem();
         if (emitllvm) {
@@ -150,7 +396,13 @@ void Config::check() {
 void Config::print_help() const {
     std::cout << "Usage: " << exe_name
               << " [-h|--help] [-o <target-file>] [-emit-llvm] [-S] [-dump-json]"
-                 "[-const-prop] [-dce]"
+                 "[-const-prop] [-dce] [-func-inline] [-sroa] "
+                 "[-global-localize] [-dse] [-global-dce] [-simplify-cfg] "
+                 "[-ipsccp] [-func-spec] [-inst-simplify] [-global-const-prop] "
+                 "[-tre] [-inline-threshold <n>] [-inline-budget <n>] "
+                 "[-inline-depth <n>] [-loop-simplify] [-licm] [-loop-promote] "
+                 "[-strength-reduce] [-loop-unroll] [-unroll-count <n>] "
+                 "[-loop-rotate] [-bce] [-loop-version] [-loop-vectorize] "
                  "<input-file>"
               << std::endl;
     exit(0);
@@ -2,6 +2,9 @@
 #include "IRprinter.hpp"
 #include "Module.hpp"
 
+#include <set>
+#include <vector>
+
 Function::Function(FunctionType *ty, const std::string &name, Module *parent)
     : Value(ty, name), parent_(parent), seq_cnt_(0) {
     // num_args_ = ty->getNumParams();
@@ -42,6 +45,51 @@ void Function::remove(BasicBlock *bb) {
     }
 }
 
+bool Function::remove_unreachable_bbs() {
+    std::set<BasicBlock *> reachable;
+    std::vector<BasicBlock *> work_list{get_entry_block()};
+    reachable.insert(get_entry_block());
+    while (not work_list.empty()) {
+        auto bb = work_list.back();
+        work_list.pop_back();
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (reachable.insert(succ).second)
+                work_list.push_back(succ);
+        }
+    }
+    std::vector<BasicBlock *> unreachable;
+    for (auto &bb : basic_blocks_) {
+        if (reachable.find(&bb) == reachable.end())
+            unreachable.push_back(&bb);
+    }
+    if (unreachable.empty())
+        return false;
+    for (auto bb : unreachable) {
+        // 可达的后继中的 phi 不再有来自该块的输入
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (reachable.find(succ) == reachable.end())
+                continue;
+            for (auto &instr : succ->get_instructions()) {
+                if (not instr.is_phi())
+                    break;
+                static_cast<PhiInst *>(&instr)->remove_phi_operand(bb);
+            }
+        }
+    }
+    for (auto bb : unreachable) {
+        // 先在所有块都存在时删除跳转指令，再断开其余指令的操作数
+        if (bb->is_terminated())
+            bb->erase_instr(bb->get_terminator());
+        for (auto &instr : bb->get_instructions())
+            instr.remove_all_operands();
+    }
+    for (auto bb : unreachable) {
+        remove(bb);
+        delete bb;
+    }
+    return true;
+}
+
 void Function::add_basic_block(BasicBlock *bb) { basic_blocks_.push_back(bb); }
 
 void Function::set_instr_name() {
@@ -87,6 +87,14 @@ std::string print_instr_op_name(Instruction::OpID id) {
         return "fptosi";
     case Instruction::sitofp:
         return "sitofp";
+    case Instruction::bitcast:
+        return "bitcast";
+    case Instruction::extractelement:
+        return "extractelement";
+    case Instruction::insertelement:
+        return "insertelement";
+    case Instruction::shufflevector:
+        return "shufflevector";
     }
     assert(false && "Must be bug");
 }
@@ -226,6 +234,11 @@ std::string StoreInst::print() {
     instr_ir += print_as_op(this->get_operand(0), false);
     instr_ir += ", ";
     instr_ir += print_as_op(this->get_operand(1), true);
+    // 向量只按元素对齐
+    auto ty = this->get_operand(0)->get_type();
+    if (ty->is_vector_type())
+        instr_ir += ", align " +
+                    std::to_string(ty->get_vector_element_type()->get_size());
     return instr_ir;
 }
 
@@ -242,6 +255,9 @@ std::string LoadInst::print() {
     instr_ir += ",";
     instr_ir += " ";
     instr_ir += print_as_op(this->get_operand(0), true);
+    if (get_type()->is_vector_type())
+        instr_ir += ", align " +
+                    std::to_string(get_type()->get_vector_element_type()->get_size());
     return instr_ir;
 }
 
@@ -301,6 +317,69 @@ std::string SiToFpInst::print() {
     return instr_ir;
 }
 
+std::string BitCastInst::print() {
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += get_instr_op_name();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += " to ";
+    instr_ir += this->get_dest_type()->print();
+    return instr_ir;
+}
+
+std::string ExtractElementInst::print() {
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += get_instr_op_name();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    return instr_ir;
+}
+
+std::string InsertElementInst::print() {
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += get_instr_op_name();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(2), true);
+    return instr_ir;
+}
+
+std::string ShuffleVectorInst::print() {
+    std::string instr_ir;
+    instr_ir += "%";
+    instr_ir += this->get_name();
+    instr_ir += " = ";
+    instr_ir += get_instr_op_name();
+    instr_ir += " ";
+    instr_ir += print_as_op(this->get_operand(0), true);
+    instr_ir += ", ";
+    instr_ir += print_as_op(this->get_operand(1), true);
+    instr_ir += ", <";
+    instr_ir += std::to_string(mask_.size());
+    instr_ir += " x i32> <";
+    for (unsigned i = 0; i < mask_.size(); i++) {
+        if (i > 0)
+            instr_ir += ", ";
+        instr_ir += "i32 " + std::to_string(mask_[i]);
+    }
+    instr_ir += ">";
+    return instr_ir;
+}
+
 std::string PhiInst::print() {
     std::string instr_ir;
     instr_ir += "%";
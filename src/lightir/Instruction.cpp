@@ -25,9 +25,12 @@ std::string Instruction::get_instr_op_name() const {
 }
 
 IBinaryInst::IBinaryInst(OpID id, Value *v1, Value *v2, BasicBlock *bb)
-    : BaseInst<IBinaryInst>(bb->get_module()->get_int32_type(), id, bb) {
-    assert(v1->get_type()->is_int32_type() && v2->get_type()->is_int32_type() &&
-           "IBinaryInst operands are not both i32");
+    : BaseInst<IBinaryInst>(v1->get_type(), id, bb) {
+    assert(v1->get_type() == v2->get_type() &&
+           (v1->get_type()->is_int32_type() or
+            (v1->get_type()->is_vector_type() and
+             v1->get_type()->get_vector_element_type()->is_int32_type())) &&
+           "IBinaryInst operands are not both i32 or both i32 vectors");
     add_operand(v1);
     add_operand(v2);
 }
@@ -46,9 +49,12 @@ IBinaryInst *IBinaryInst::create_sdiv(Value *v1, Value *v2, BasicBlock *bb) {
 }
 
 FBinaryInst::FBinaryInst(OpID id, Value *v1, Value *v2, BasicBlock *bb)
-    : BaseInst<FBinaryInst>(bb->get_module()->get_float_type(), id, bb) {
-    assert(v1->get_type()->is_float_type() && v2->get_type()->is_float_type() &&
-           "FBinaryInst operands are not both float");
+    : BaseInst<FBinaryInst>(v1->get_type(), id, bb) {
+    assert(v1->get_type() == v2->get_type() &&
+           (v1->get_type()->is_float_type() or
+            (v1->get_type()->is_vector_type() and
+             v1->get_type()->get_vector_element_type()->is_float_type())) &&
+           "FBinaryInst operands are not both float or both float vectors");
     add_operand(v1);
     add_operand(v2);
 }
@@ -123,7 +129,7 @@ FCmpInst *FCmpInst::create_fne(Value *v1, Value *v2, BasicBlock *bb) {
 }
 
 CallInst::CallInst(Function *func, std::vector<Value *> args, BasicBlock *bb)
-    : BaseInst<CallInst>(func->get_return_type(), call, bb) {
+    : BaseInst<CallInst>(func->get_return_type(), call, bb), func_(func) {
     assert(func->get_type()->is_function_type() && "Not a function");
     assert((func->get_num_of_args() == args.size()) && "Wrong number of args");
     add_operand(func);
@@ -276,8 +282,8 @@ LoadInst::LoadInst(Value *ptr, BasicBlock *bb)
     : BaseInst<LoadInst>(ptr->get_type()->get_pointer_element_type(), load,
                          bb) {
     assert((get_type()->is_integer_type() or get_type()->is_float_type() or
-            get_type()->is_pointer_type()) &&
-           "Should not load value with type except int/float");
+            get_type()->is_pointer_type() or get_type()->is_vector_type()) &&
+           "Should not load value with type except int/float/vector");
     add_operand(ptr);
 }
 
@@ -345,6 +351,67 @@ SiToFpInst *SiToFpInst::create_sitofp(Value *val, BasicBlock *bb) {
     return create(val, bb->get_module()->get_float_type(), bb);
 }
 
+BitCastInst::BitCastInst(Value *val, Type *ty, BasicBlock *bb)
+    : BaseInst<BitCastInst>(ty, bitcast, bb) {
+    assert(val->get_type()->is_pointer_type() && ty->is_pointer_type() &&
+           "BitCastInst only converts between pointer types");
+    add_operand(val);
+}
+
+BitCastInst *BitCastInst::create_bitcast(Value *val, Type *ty, BasicBlock *bb) {
+    return create(val, ty, bb);
+}
+
+ExtractElementInst::ExtractElementInst(Value *vec, Value *idx, BasicBlock *bb)
+    : BaseInst<ExtractElementInst>(vec->get_type()->get_vector_element_type(),
+                                   extractelement, bb) {
+    assert(idx->get_type()->is_int32_type() && "Index is not i32");
+    add_operand(vec);
+    add_operand(idx);
+}
+
+ExtractElementInst *ExtractElementInst::create_extractelement(Value *vec,
+                                                              Value *idx,
+                                                              BasicBlock *bb) {
+    return create(vec, idx, bb);
+}
+
+InsertElementInst::InsertElementInst(Value *vec, Value *elt, Value *idx,
+                                     BasicBlock *bb)
+    : BaseInst<InsertElementInst>(vec->get_type(), insertelement, bb) {
+    assert(vec->get_type()->get_vector_element_type() == elt->get_type() &&
+           "InsertElementInst element type mismatch");
+    assert(idx->get_type()->is_int32_type() && "Index is not i32");
+    add_operand(vec);
+    add_operand(elt);
+    add_operand(idx);
+}
+
+InsertElementInst *InsertElementInst::create_insertelement(Value *vec,
+                                                           Value *elt,
+                                                           Value *idx,
+                                                           BasicBlock *bb) {
+    return create(vec, elt, idx, bb);
+}
+
+ShuffleVectorInst::ShuffleVectorInst(Value *v1, Value *v2,
+                                     std::vector<int> mask, BasicBlock *bb)
+    : BaseInst<ShuffleVectorInst>(
+          VectorType::get(v1->get_type()->get_vector_element_type(),
+                          mask.size()),
+          shufflevector, bb),
+      mask_(std::move(mask)) {
+    assert(v1->get_type() == v2->get_type() &&
+           "ShuffleVectorInst operands are not the same type");
+    add_operand(v1);
+    add_operand(v2);
+}
+
+ShuffleVectorInst *ShuffleVectorInst::create_shufflevector(
+    Value *v1, Value *v2, std::vector<int> mask, BasicBlock *bb) {
+    return create(v1, v2, std::move(mask), bb);
+}
+
 PhiInst::PhiInst(Type *ty, std::vector<Value *> vals,
                  std::vector<BasicBlock *> val_bbs, BasicBlock *bb)
     : BaseInst<PhiInst>(ty, phi) {
@@ -376,8 +443,13 @@ Instruction *FCmpInst::clone(BasicBlock *prt) const  {
 
 
 
+Instruction *CallInst::clone(BasicBlock *prt) const  {
+  auto func = static_cast<Function *>(get_operand(0));
+  return new CallInst(func, {get_operands().begin() + 1, get_operands().end()}, prt);
+}
+
 Instruction *ReturnInst::clone(BasicBlock *prt) const  {
-  return new ReturnInst(get_operand(0), prt);
+  return new ReturnInst(is_void_ret() ? nullptr : get_operand(0), prt);
 }
 
 Instruction *StoreInst::clone(BasicBlock *prt) const  {
@@ -404,6 +476,23 @@ Instruction *SiToFpInst::clone(BasicBlock *prt) const  {
   return new SiToFpInst(get_operand(0), get_type(), prt);
 }
 
+Instruction *BitCastInst::clone(BasicBlock *prt) const {
+    return new BitCastInst(get_operand(0), get_type(), prt);
+}
+
+Instruction *ExtractElementInst::clone(BasicBlock *prt) const {
+    return new ExtractElementInst(get_operand(0), get_operand(1), prt);
+}
+
+Instruction *InsertElementInst::clone(BasicBlock *prt) const {
+    return new InsertElementInst(get_operand(0), get_operand(1),
+                                 get_operand(2), prt);
+}
+
+Instruction *ShuffleVectorInst::clone(BasicBlock *prt) const {
+    return new ShuffleVectorInst(get_operand(0), get_operand(1), mask_, prt);
+}
+
 Instruction *PhiInst::clone(BasicBlock *prt) const  {
   auto temp = new PhiInst(get_type(), {}, {}, prt);
     for (unsigned i = 0; i < get_num_operand(); i += 2) {
@@ -40,6 +40,14 @@ ArrayType *Module::get_array_type(Type *contained, unsigned num_elements) {
     return array_map_[{contained, num_elements}].get();
 }
 
+VectorType *Module::get_vector_type(Type *contained, unsigned num_elements) {
+    if (vector_map_.find({contained, num_elements}) == vector_map_.end()) {
+        vector_map_[{contained, num_elements}] =
+            std::make_unique<VectorType>(contained, num_elements);
+    }
+    return vector_map_[{contained, num_elements}].get();
+}
+
 FunctionType *Module::get_function_type(Type *retty,
                                         std::vector<Type *> &args) {
     if (not function_map_.count({retty, args})) {
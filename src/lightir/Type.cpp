@@ -31,6 +31,12 @@ Type *Type::get_array_element_type() const {
     assert(false and "get_array_element_type() called on non-array type");
 }
 
+Type *Type::get_vector_element_type() const {
+    if (this->is_vector_type())
+        return static_cast<const VectorType *>(this)->get_element_type();
+    assert(false and "get_vector_element_type() called on non-vector type");
+}
+
 unsigned Type::get_size() const {
     switch (get_type_id()) {
     case IntegerTyID: {
@@ -47,6 +53,11 @@ unsigned Type::get_size() const {
         auto num_elements = array_type->get_num_of_elements();
         return element_size * num_elements;
     }
+    case VectorTyID: {
+        auto vector_type = static_cast<const VectorType *>(this);
+        return vector_type->get_element_type()->get_size() *
+               vector_type->get_num_of_elements();
+    }
     case PointerTyID:
         return 8;
     case FloatTyID:
@@ -104,6 +115,15 @@ std::string Type::print() const {
     case FloatTyID:
         type_ir += "float";
         break;
+    case VectorTyID:
+        type_ir += "<";
+        type_ir += std::to_string(
+            static_cast<const VectorType *>(this)->get_num_of_elements());
+        type_ir += " x ";
+        type_ir +=
+            static_cast<const VectorType *>(this)->get_element_type()->print();
+        type_ir += ">";
+        break;
     default:
         break;
     }
@@ -165,13 +185,30 @@ ArrayType *ArrayType::get(Type *contained, unsigned num_elements) {
 PointerType::PointerType(Type *contained)
     : Type(Type::PointerTyID, contained->get_module()), contained_(contained) {
     static const std::array allowed_elem_type = {
-        Type::IntegerTyID, Type::FloatTyID, Type::ArrayTyID, Type::PointerTyID};
+        Type::IntegerTyID, Type::FloatTyID, Type::ArrayTyID, Type::PointerTyID,
+        Type::VectorTyID};
     auto elem_type_id = contained->get_type_id();
     assert(std::find(allowed_elem_type.begin(), allowed_elem_type.end(),
                      elem_type_id) != allowed_elem_type.end() &&
            "Not allowed type for pointer");
 }
 
+VectorType::VectorType(Type *contained, unsigned num_elements)
+    : Type(Type::VectorTyID, contained->get_module()),
+      num_elements_(num_elements) {
+    assert(is_valid_element_type(contained) &&
+           "Not a valid type for vector element!");
+    contained_ = contained;
+}
+
+bool VectorType::is_valid_element_type(Type *ty) {
+    return ty->is_int32_type() || ty->is_float_type();
+}
+
+VectorType *VectorType::get(Type *contained, unsigned num_elements) {
+    return contained->get_module()->get_vector_type(contained, num_elements);
+}
+
 PointerType *PointerType::get(Type *contained) {
     return contained->get_module()->get_pointer_type(contained);
 }
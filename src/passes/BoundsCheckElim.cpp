@@ -0,0 +1,45 @@
+#include "BoundsCheckElim.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
+
+#include <vector>
+
+void BoundsCheckElim::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        func.remove_unreachable_bbs();
+        range_->run_on_func(&func);
+
+        // 先找出全部可删的检查再修改，分析结果不受影响
+        std::vector<std::pair<BasicBlock *, BasicBlock *>> removable;
+        for (auto &bb : func.get_basic_blocks()) {
+            auto br = bb.get_terminator();
+            if (not br->is_br() or br->get_num_operand() != 3)
+                continue;
+            auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+            auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+            auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+            if (cmp == nullptr or
+                RangeAnalysis::is_trap_block(true_bb) ==
+                    RangeAnalysis::is_trap_block(false_bb))
+                continue;
+            bool res;
+            if (not range_->eval_cmp(cmp, cmp->get_parent(), res))
+                continue;
+            auto target = res ? true_bb : false_bb;
+            if (not RangeAnalysis::is_trap_block(target))
+                removable.push_back({&bb, target});
+        }
+
+        for (auto [bb, target] : removable) {
+            bb->erase_instr(bb->get_terminator());
+            BranchInst::create_br(target, bb);
+            removed_count_++;
+        }
+        func.remove_unreachable_bbs();
+    }
+    LOG_INFO << "bounds check elim removed " << removed_count_ << " checks";
+}
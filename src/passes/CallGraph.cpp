@@ -0,0 +1,89 @@
+#include "CallGraph.hpp"
+#include "Module.hpp"
+
+#include <algorithm>
+
+void CallGraph::run() {
+    callees_.clear();
+    callers_.clear();
+    call_sites_.clear();
+    recursive_.clear();
+    sccs_.clear();
+    scc_id_.clear();
+    dfn_.clear();
+    low_.clear();
+    stack_.clear();
+    on_stack_.clear();
+    index_ = 0;
+
+    for (auto &f : m_->get_functions()) {
+        callees_[&f];
+        callers_[&f];
+        call_sites_[&f];
+    }
+    for (auto &f : m_->get_functions()) {
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &instr : bb.get_instructions()) {
+                if (not instr.is_call())
+                    continue;
+                auto call = static_cast<CallInst *>(&instr);
+                auto callee = static_cast<Function *>(call->get_operand(0));
+                call_sites_[callee].push_back(call);
+                auto &callees = callees_[&f];
+                if (std::find(callees.begin(), callees.end(), callee) ==
+                    callees.end()) {
+                    callees.push_back(callee);
+                    callers_[callee].push_back(&f);
+                }
+                if (callee == &f)
+                    recursive_.insert(&f);
+            }
+        }
+    }
+    for (auto &f : m_->get_functions()) {
+        if (dfn_.find(&f) == dfn_.end())
+            tarjan(&f);
+    }
+}
+
+void CallGraph::tarjan(Function *f) {
+    dfn_[f] = low_[f] = ++index_;
+    stack_.push_back(f);
+    on_stack_.insert(f);
+    for (auto callee : callees_[f]) {
+        if (dfn_.find(callee) == dfn_.end()) {
+            tarjan(callee);
+            low_[f] = std::min(low_[f], low_[callee]);
+        } else if (on_stack_.count(callee)) {
+            low_[f] = std::min(low_[f], dfn_[callee]);
+        }
+    }
+    if (low_[f] != dfn_[f])
+        return;
+    FuncList scc;
+    Function *top;
+    do {
+        top = stack_.back();
+        stack_.pop_back();
+        on_stack_.erase(top);
+        scc_id_[top] = sccs_.size();
+        scc.push_back(top);
+    } while (top != f);
+    if (scc.size() > 1)
+        recursive_.insert(scc.begin(), scc.end());
+    sccs_.push_back(scc);
+}
+
+std::set<Function *> CallGraph::get_reachable(Function *root) {
+    std::set<Function *> reachable{root};
+    std::vector<Function *> work_list{root};
+    while (not work_list.empty()) {
+        auto f = work_list.back();
+        work_list.pop_back();
+        for (auto callee : callees_.at(f)) {
+            if (reachable.insert(callee).second)
+                work_list.push_back(callee);
+        }
+    }
+    return reachable;
+}
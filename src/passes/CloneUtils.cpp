@@ -0,0 +1,110 @@
+#include "CloneUtils.hpp"
+#include "BasicBlock.hpp"
+#include "Instruction.hpp"
+
+namespace {
+std::vector<BasicBlock *>
+clone_block_list(const std::vector<BasicBlock *> &src_bbs, Function *dst,
+                 std::map<Value *, Value *> &v_map, BasicBlock *ret_target,
+                 std::vector<std::pair<Value *, BasicBlock *>> *ret_vals) {
+    auto m = dst->get_parent();
+    std::vector<BasicBlock *> new_bbs;
+    for (auto bb : src_bbs) {
+        auto new_bb = BasicBlock::create(m, "", dst);
+        v_map[bb] = new_bb;
+        new_bbs.push_back(new_bb);
+    }
+
+    // 先按原样复制指令，之后再统一替换操作数，以处理前向引用
+    std::vector<Instruction *> new_instrs;
+    std::vector<std::pair<Value *, BasicBlock *>> rets;
+    auto new_bb = new_bbs.begin();
+    for (auto bb : src_bbs) {
+        for (auto &instr : bb->get_instructions()) {
+            // 已给出映射的 phi（如展开循环时循环头的 phi）不复制
+            if (instr.is_phi() and v_map.count(&instr))
+                continue;
+            if (instr.is_ret() and ret_target != nullptr) {
+                auto ret = static_cast<ReturnInst *>(&instr);
+                rets.push_back({ret->is_void_ret() ? nullptr : ret->get_operand(0),
+                                *new_bb});
+                continue;
+            }
+            auto new_instr = instr.clone(*new_bb);
+            // phi 的构造函数不会把自身插入基本块
+            if (instr.is_phi())
+                (*new_bb)->add_instruction(new_instr);
+            v_map[&instr] = new_instr;
+            new_instrs.push_back(new_instr);
+        }
+        ++new_bb;
+    }
+    for (auto instr : new_instrs) {
+        for (unsigned i = 0; i < instr->get_num_operand(); i++) {
+            auto it = v_map.find(instr->get_operand(i));
+            if (it != v_map.end())
+                instr->set_operand(i, it->second);
+        }
+    }
+
+    // 复制的跳转指令在构造时把原函数的块登记为后继，这里改为新块
+    auto old_bb = src_bbs.begin();
+    for (auto bb : new_bbs) {
+        for (auto succ : (*old_bb)->get_succ_basic_blocks())
+            succ->remove_pre_basic_block(bb);
+        bb->get_succ_basic_blocks().clear();
+        if (not bb->is_terminated()) {
+            ++old_bb;
+            continue;
+        }
+        auto term = bb->get_terminator();
+        if (term->is_br()) {
+            for (auto op : term->get_operands()) {
+                if (auto succ = dynamic_cast<BasicBlock *>(op)) {
+                    bb->add_succ_basic_block(succ);
+                    succ->add_pre_basic_block(bb);
+                }
+            }
+        }
+        ++old_bb;
+    }
+
+    for (auto &[val, bb] : rets) {
+        BranchInst::create_br(ret_target, bb);
+        auto it = v_map.find(val);
+        if (ret_vals != nullptr)
+            ret_vals->push_back({it != v_map.end() ? it->second : val, bb});
+    }
+    return new_bbs;
+}
+} // namespace
+
+std::vector<BasicBlock *>
+clone_blocks(Function *src, Function *dst, std::map<Value *, Value *> &v_map,
+             BasicBlock *ret_target,
+             std::vector<std::pair<Value *, BasicBlock *>> *ret_vals) {
+    std::vector<BasicBlock *> src_bbs;
+    for (auto &bb : src->get_basic_blocks())
+        src_bbs.push_back(&bb);
+    return clone_block_list(src_bbs, dst, v_map, ret_target, ret_vals);
+}
+
+std::vector<BasicBlock *>
+clone_region(const std::vector<BasicBlock *> &bbs,
+             std::map<Value *, Value *> &v_map) {
+    return clone_block_list(bbs, bbs.front()->get_parent(), v_map, nullptr,
+                            nullptr);
+}
+
+Function *clone_function(Function *src, const std::string &name) {
+    auto func = Function::create(src->get_function_type(), name,
+                                 src->get_parent());
+    std::map<Value *, Value *> v_map;
+    auto new_arg = func->get_args().begin();
+    for (auto &arg : src->get_args()) {
+        v_map[&arg] = &*new_arg;
+        ++new_arg;
+    }
+    clone_blocks(src, func, v_map);
+    return func;
+}
@@ -3,21 +3,34 @@
 #include "Instruction.hpp"
 #include "logging.hpp"
 
+#include <climits>
+#include <cmath>
+
 ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantInt *value1, ConstantInt *value2) {
     int c_value1 = value1->get_value();
     int c_value2 = value2->get_value();
 
     switch (op) {
+    // 按 32 位补码回绕计算，避免有符号溢出
     case Instruction::add:
-        return ConstantInt::get(c_value1 + c_value2, module_);
+        return ConstantInt::get(static_cast<int>(static_cast<unsigned>(c_value1) +
+                                                 static_cast<unsigned>(c_value2)),
+                                module_);
         break;
     case Instruction::sub:
-        return ConstantInt::get(c_value1 - c_value2, module_);
+        return ConstantInt::get(static_cast<int>(static_cast<unsigned>(c_value1) -
+                                                 static_cast<unsigned>(c_value2)),
+                                module_);
         break;
     case Instruction::mul:
-        return ConstantInt::get(c_value1 * c_value2, module_);
+        return ConstantInt::get(static_cast<int>(static_cast<unsigned>(c_value1) *
+                                                 static_cast<unsigned>(c_value2)),
+                                module_);
         break;
     case Instruction::sdiv:
+        // 除零与 INT_MIN / -1 在运行时才会出错，不做折叠
+        if (c_value2 == 0 || (c_value1 == INT_MIN && c_value2 == -1))
+            return nullptr;
         return ConstantInt::get(static_cast<int>(c_value1 / c_value2), module_);
         break;
     case Instruction::eq:
@@ -44,9 +57,11 @@ ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantInt *value1, Con
     }
 }
 
-ConstantFP *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1, ConstantFP *value2) {
+Constant *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1, ConstantFP *value2) {
     float c_value1 = value1->get_value();
     float c_value2 = value2->get_value();
+    // 浮点比较是无序比较（ueq、une 等），任一操作数为 NaN 时结果为真
+    bool unordered = std::isnan(c_value1) || std::isnan(c_value2);
     switch (op) {
     case Instruction::fadd:
         return ConstantFP::get(c_value1 + c_value2, module_);
@@ -61,22 +76,22 @@ ConstantFP *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1, Const
         return ConstantFP::get(c_value1 / c_value2, module_);
         break;
     case Instruction::feq:
-        return ConstantFP::get(c_value1 == c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 == c_value2, module_);
         break;
     case Instruction::fne:
-        return ConstantFP::get(c_value1 != c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 != c_value2, module_);
         break;
     case Instruction::fgt:
-        return ConstantFP::get(c_value1 > c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 > c_value2, module_);
         break;
     case Instruction::fge:
-        return ConstantFP::get(c_value1 >= c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 >= c_value2, module_);
         break;
     case Instruction::flt:
-        return ConstantFP::get(c_value1 < c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 < c_value2, module_);
         break;
     case Instruction::fle:
-        return ConstantFP::get(c_value1 <= c_value2, module_);
+        return ConstantInt::get(unordered || c_value1 <= c_value2, module_);
         break;
     default:
         return nullptr;
@@ -110,6 +125,33 @@ ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1) {
     }
 }
 
+Constant *ConstFolder::compute(Instruction *instr, const std::vector<Constant *> &ops) {
+    auto op = instr->get_instr_type();
+    if (instr->isBinary() || instr->is_cmp() || instr->is_fcmp()) {
+        if (auto lhs = cast_constantint(ops[0]), rhs = cast_constantint(ops[1]); lhs && rhs)
+            return compute(op, lhs, rhs);
+        if (auto lhs = cast_constantfp(ops[0]), rhs = cast_constantfp(ops[1]); lhs && rhs)
+            return compute(op, lhs, rhs);
+        return nullptr;
+    }
+    if (instr->is_zext()) {
+        if (auto val = cast_constantint(ops[0]))
+            return ConstantInt::get(val->get_value() & 1, module_);
+        return nullptr;
+    }
+    if (instr->is_si2fp()) {
+        if (auto val = cast_constantint(ops[0]))
+            return compute(op, val);
+        return nullptr;
+    }
+    if (instr->is_fp2si()) {
+        if (auto val = cast_constantfp(ops[0]))
+            return compute(op, val);
+        return nullptr;
+    }
+    return nullptr;
+}
+
 ConstantFP *cast_constantfp(Value *value) {
     auto constant_fp_ptr = dynamic_cast<ConstantFP *>(value);
     if (constant_fp_ptr) {
@@ -125,92 +167,232 @@ ConstantInt *cast_constantint(Value *value) {
     return nullptr;
 }
 
-void ConstPropagation::run() {
-    for (auto &func : m_->get_functions()) {
 
-        for (auto &bb : func.get_basic_blocks()) {
-            wait_delete.clear();
-
-            for (auto &instr : bb.get_instructions()) {
-                // clear glbalvar_def map
-
-                if (instr.is_add() || instr.is_sub() || instr.is_mul() || instr.is_div()) {
-                    auto value1 = cast_constantint(instr.get_operand(0));
-                    auto value2 = cast_constantint(instr.get_operand(1));
-                    if (value1 && value2) {
-                        auto fold_const = folder->compute(instr.get_instr_type(), value1, value2);
-
-                        instr.replace_all_use_with(fold_const);
-                        wait_delete.push_back(&instr);
-                    }
-                }
-                // TODO: fold other type of expression
-                throw std::runtime_error("Lab2: 你有一个TODO需要完成！");
-            }
-            globalvar_def.clear();
-            for (auto instr : wait_delete) {
-                bb.erase_instr(instr);
-            }
+ConstPropagation::LatticeVal ConstPropagation::get_lattice(Value *val) {
+    if (auto c = dynamic_cast<Constant *>(val))
+        return {LatticeVal::constant, c};
+    // 参数、全局变量等在过程内分析中都视为非常量
+    if (dynamic_cast<Instruction *>(val) == nullptr)
+        return {LatticeVal::overdefined, nullptr};
+    auto it = lattice_.find(val);
+    if (it == lattice_.end())
+        return {};
+    return it->second;
+}
+
+void ConstPropagation::merge_lattice(Value *val, LatticeVal new_val) {
+    if (new_val.is_undef())
+        return;
+    auto &old_val = lattice_[val];
+    if (old_val.is_overdefined())
+        return;
+    if (old_val.is_constant() and new_val.is_constant() and
+        old_val.value == new_val.value)
+        return;
+    if (old_val.is_undef() and new_val.is_constant())
+        old_val = new_val;
+    else
+        old_val = {LatticeVal::overdefined, nullptr};
+    for (auto &use : val->get_use_list()) {
+        auto user = dynamic_cast<Instruction *>(use.val_);
+        if (user and executable_bbs_.count(user->get_parent()))
+            instr_work_list_.push_back(user);
+    }
+}
+
+void ConstPropagation::mark_constant(Value *val, Constant *c) {
+    merge_lattice(val, {LatticeVal::constant, c});
+}
+
+void ConstPropagation::mark_overdefined(Value *val) {
+    merge_lattice(val, {LatticeVal::overdefined, nullptr});
+}
+
+void ConstPropagation::mark_block(BasicBlock *bb) {
+    if (executable_bbs_.insert(bb).second)
+        bb_work_list_.push_back(bb);
+}
+
+void ConstPropagation::mark_edge(BasicBlock *from, BasicBlock *to) {
+    if (not executable_edges_.insert({from, to}).second)
+        return;
+    if (executable_bbs_.count(to)) {
+        // 块已可执行，只需重新计算新边带来的 phi 输入
+        for (auto &instr : to->get_instructions()) {
+            if (not instr.is_phi())
+                break;
+            instr_work_list_.push_back(&instr);
         }
+    } else {
+        mark_block(to);
     }
+}
 
-    for (auto &func : m_->get_functions()) {
-        for (auto &bb : func.get_basic_blocks()) {
-            builder->set_insert_point(&bb);
-            // TODO: check if conditional branch's condition is constant
-            throw std::runtime_error("Lab2: 你有一个TODO需要完成！");
+void ConstPropagation::solve() {
+    while (not bb_work_list_.empty() or not instr_work_list_.empty()) {
+        while (not instr_work_list_.empty()) {
+            auto instr = instr_work_list_.front();
+            instr_work_list_.pop_front();
+            visit(instr);
         }
-        for (auto bb : delete_bb) {
-            clear_blocks_recs(bb);
+        while (not bb_work_list_.empty()) {
+            auto bb = bb_work_list_.front();
+            bb_work_list_.pop_front();
+            for (auto &instr : bb->get_instructions())
+                visit(&instr);
         }
-        delete_bb.clear();
     }
 }
 
-bool ConstPropagation::is_entry(BasicBlock *bb) {
-    // TODO
-    throw std::runtime_error("Lab2: 你有一个TODO需要完成！");
-    return false;
+void ConstPropagation::visit(Instruction *instr) {
+    if (instr->is_br())
+        visit_br(static_cast<BranchInst *>(instr));
+    else if (instr->is_call())
+        visit_call(static_cast<CallInst *>(instr));
+    else if (instr->is_ret())
+        visit_ret(static_cast<ReturnInst *>(instr));
+    else if (get_lattice(instr).is_overdefined())
+        return;
+    else if (instr->is_phi())
+        visit_phi(static_cast<PhiInst *>(instr));
+    else if (instr->isBinary() or instr->is_cmp() or instr->is_fcmp() or
+             instr->is_zext() or instr->is_fp2si() or instr->is_si2fp())
+        visit_expr(instr);
+    else if (not instr->is_void())
+        mark_overdefined(instr);
 }
 
-void ConstPropagation::clear_blocks_recs(BasicBlock *start_bb) {
-    auto func = start_bb->get_parent();
-    if (func == nullptr) {
-        LOG(ERROR) << "basic block-" << start_bb->get_name() << " has no parent function";
-    } else {
-        auto prev_bb = start_bb->get_pre_basic_blocks();
-        // start_bb has no previous bb and is not the entry of parent function
-        if (prev_bb.size() == 0 && !is_entry(start_bb)) {
-            func->remove(start_bb);
-            auto succ_bb = start_bb->get_succ_basic_blocks();
-            for (auto each_succ_bb : succ_bb) {
-                std::vector<Instruction*> del_inst;
-                for (auto &instr1 : each_succ_bb->get_instructions()) {
-                    auto instr = &instr1;
-                    if (instr->is_phi()) {
-                        LOG(DEBUG) << "Find a PHI instruction in the sucess node of "
-                                      "useless branch";
-                        for (int i = 1; i < instr->get_num_operand(); i += 2) {
-                            if (instr->get_operand(i) == start_bb &&
-                                start_bb->get_pre_basic_blocks().size() <= 0) {
-                                LOG(DEBUG) << "remove unuseful phi branch in the index of " << i - 1
-                                           << " and " << i;
-
-                                instr->remove_operand(i - 1);
-                                instr->remove_operand(i - 1);
-                            }
-                        }
-                        int operands_num_phi = instr->get_num_operand();
-                        if (operands_num_phi == 2) {
-                            auto value = instr->get_operand(0);
-                            instr->replace_all_use_with(cast_constantint(value));
-                            del_inst.push_back(instr);
-                        }
-                    }
-                }
-                for(auto instr : del_inst) each_succ_bb->erase_instr(instr);
-                clear_blocks_recs(each_succ_bb);
-            }
+void ConstPropagation::visit_call(CallInst *call) {
+    if (not call->is_void())
+        mark_overdefined(call);
+}
+
+void ConstPropagation::visit_phi(PhiInst *phi) {
+    auto bb = phi->get_parent();
+    for (auto [val, pre_bb] : phi->get_phi_pairs()) {
+        // 只有来自可执行边的输入参与求交
+        if (executable_edges_.count({pre_bb, bb}))
+            merge_lattice(phi, get_lattice(val));
+    }
+}
+
+void ConstPropagation::visit_br(BranchInst *br) {
+    auto bb = br->get_parent();
+    if (not br->is_cond_br()) {
+        mark_edge(bb, static_cast<BasicBlock *>(br->get_operand(0)));
+        return;
+    }
+    auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+    auto cond = get_lattice(br->get_operand(0));
+    if (cond.is_overdefined()) {
+        mark_edge(bb, true_bb);
+        mark_edge(bb, false_bb);
+    } else if (cond.is_constant()) {
+        auto c = cast_constantint(cond.value);
+        mark_edge(bb, c->get_value() ? true_bb : false_bb);
+    }
+}
+
+void ConstPropagation::visit_expr(Instruction *instr) {
+    std::vector<Constant *> ops;
+    for (auto op : instr->get_operands()) {
+        auto val = get_lattice(op);
+        if (val.is_overdefined()) {
+            mark_overdefined(instr);
+            return;
         }
+        // 操作数尚未确定时等待其格值变化后再计算
+        if (val.is_undef())
+            return;
+        ops.push_back(val.value);
+    }
+    auto c = folder->compute(instr, ops);
+    if (c == nullptr)
+        mark_overdefined(instr);
+    else
+        mark_constant(instr, c);
+}
+
+bool ConstPropagation::resolve_undef_branches(Function *func) {
+    bool changed = false;
+    for (auto bb : executable_bbs_) {
+        if (bb->get_parent() != func)
+            continue;
+        auto term = bb->get_terminator();
+        if (not term->is_br() or
+            not static_cast<BranchInst *>(term)->is_cond_br())
+            continue;
+        auto cond = term->get_operand(0);
+        if (not get_lattice(cond).is_undef())
+            continue;
+        mark_overdefined(cond);
+        instr_work_list_.push_back(term);
+        changed = true;
+    }
+    return changed;
+}
+
+int ConstPropagation::rewrite(Function *func) {
+    int count = 0;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (not executable_bbs_.count(&bb))
+            continue;
+        std::vector<Instruction *> wait_delete;
+        for (auto &instr : bb.get_instructions()) {
+            auto val = get_lattice(&instr);
+            if (not val.is_constant())
+                continue;
+            instr.replace_all_use_with(val.value);
+            // 调用可能有副作用，只替换其返回值
+            if (not instr.is_call())
+                wait_delete.push_back(&instr);
+        }
+        for (auto instr : wait_delete) {
+            bb.erase_instr(instr);
+            count++;
+        }
+    }
+
+    // 只有一条出边可执行的条件跳转改为无条件跳转
+    for (auto &bb : func->get_basic_blocks()) {
+        if (not executable_bbs_.count(&bb))
+            continue;
+        auto term = bb.get_terminator();
+        if (not term->is_br() or
+            not static_cast<BranchInst *>(term)->is_cond_br())
+            continue;
+        auto true_bb = static_cast<BasicBlock *>(term->get_operand(1));
+        auto false_bb = static_cast<BasicBlock *>(term->get_operand(2));
+        bool true_exec = executable_edges_.count({&bb, true_bb});
+        bool false_exec = executable_edges_.count({&bb, false_bb});
+        if (true_exec == false_exec)
+            continue;
+        auto target = true_exec ? true_bb : false_bb;
+        auto other = true_exec ? false_bb : true_bb;
+        for (auto &instr : other->get_instructions()) {
+            if (not instr.is_phi())
+                break;
+            static_cast<PhiInst *>(&instr)->remove_phi_operand(&bb);
+        }
+        bb.erase_instr(term);
+        BranchInst::create_br(target, &bb);
+    }
+
+    // 不可执行的块此时都已不可达
+    func->remove_unreachable_bbs();
+    return count;
+}
+
+void ConstPropagation::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        mark_block(func.get_entry_block());
+        do {
+            solve();
+        } while (resolve_undef_branches(&func));
+        folded_count_ += rewrite(&func);
     }
+    LOG_INFO << "const propagation folded " << folded_count_ << " instructions";
 }
@@ -2,53 +2,33 @@
 #include "Instruction.hpp"
 #include "logging.hpp"
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
-// 处理流程：两趟处理，mark 标记有用变量，sweep 删除无用指令
+// 处理流程：先删除不可达基本块，mark 标记有用指令，sweep 一趟删除其余指令
+// 活跃性由关键指令沿操作数传递，一次标记即为不动点，无需整模块反复迭代
 void DeadCode::run() {
-    bool changed{};
     func_info->run();
-    do {
-        changed = false;
-        for (auto &F : m_->get_functions()) {
-            auto func = &F;
-            changed |= clear_basic_blocks(func);
-            mark(func);
-            changed |= sweep(func);
-        }
-    } while (changed);
-    LOG_INFO << "dead code pass erased " << ins_count << " instructions";
-}
-
-bool DeadCode::clear_basic_blocks(Function *func) {
-    bool changed = 0;
-    std::vector<BasicBlock *> to_erase;
-    for (auto &bb1 : func->get_basic_blocks()) {
-        auto bb = &bb1;
-        if(bb->get_pre_basic_blocks().empty() && bb != func->get_entry_block()) {
-            to_erase.push_back(bb);
-            changed = 1;
-        }
-    }
-    for (auto &bb : to_erase) {
-        bb->erase_from_parent();
-        delete bb;
+    func_info_ready = true;
+    for (auto &F : m_->get_functions()) {
+        auto func = &F;
+        if (func->is_declaration())
+            continue;
+        func->remove_unreachable_bbs();
+        mark(func);
+        sweep(func);
     }
-    return changed;
+    LOG_INFO << "dead code pass erased " << ins_count << " instructions";
 }
 
 void DeadCode::mark(Function *func) {
     work_list.clear();
-    marked.clear();
-    int func_num = func->get_num_basic_blocks(); 
     // 1. 找到所有关键指令作为“活代码”的起点
     for (auto &bb : func->get_basic_blocks()) {
         for (auto &ins : bb.get_instructions()) {
-            if (is_critical(&ins)) {
-                if (!marked[&ins]) {
-                    marked[&ins] = true;
-                    work_list.push_back(&ins);
-                }
+            if (is_critical(&ins) and not ins.is_marked()) {
+                ins.set_marked(true);
+                work_list.push_back(&ins);
             }
         }
     }
@@ -60,7 +40,6 @@ void DeadCode::mark(Function *func) {
         // 调用辅助函数来标记其操作数
         mark(ins);
     }
-    
 }
 
 void DeadCode::mark(Instruction *ins) {
@@ -68,43 +47,75 @@ void DeadCode::mark(Instruction *ins) {
         auto def = dynamic_cast<Instruction *>(op);
         if (def == nullptr)
             continue;
-        if (marked[def])
+        if (def->is_marked())
             continue;
         if (def->get_function() != ins->get_function())
             continue;
-        marked[def] = true;
+        def->set_marked(true);
         work_list.push_back(def);
     }
 }
 
 bool DeadCode::sweep(Function *func) {
-    // TODO: 删除无用指令
-    // 提示：
-    // 1. 遍历函数的基本块，删除所有标记为true的指令
-    // 2. 删除指令后，可能会导致其他指令的操作数变为无用，因此需要再次遍历函数的基本块
-    // 3. 如果删除了指令，返回true，否则返回false
-    // 4. 注意：删除指令时，需要先删除操作数的引用，然后再删除指令本身
-    // 5. 删除指令时，需要注意指令的顺序，不能删除正在遍历的指令
-    std::unordered_set<Instruction *> wait_del{};
-
-    // 1. 收集所有未被标记的指令
+    // 1. 收集所有未被标记的指令，同时清除活跃标记供下次使用
+    std::vector<Instruction *> wait_del{};
     for (auto &bb : func->get_basic_blocks()) {
         for (auto &ins : bb.get_instructions()) {
-            if (!marked[&ins]) {
-                wait_del.insert(&ins);
-            }
+            if (ins.is_marked())
+                ins.set_marked(false);
+            else
+                wait_del.push_back(&ins);
         }
     }
 
-    // 2. 执行删除
+    // 2. 死指令之间可能互相引用，先断开所有操作数再删除
+    for (auto ins : wait_del)
+        ins->remove_all_operands();
     for (auto ins : wait_del) {
         ins->get_parent()->erase_instr(ins); // 从基本块中删除指令
         ins_count++;
     }
-    
+
     return not wait_del.empty(); // changed
 }
 
+int DeadCode::erase_trivially_dead(std::vector<Instruction *> seeds) {
+    if (not func_info_ready) {
+        func_info->run();
+        func_info_ready = true;
+    }
+    int erased = 0;
+    // 同一指令只在工作表中出现一次，避免删除后再次访问
+    std::unordered_set<Instruction *> in_list;
+    std::vector<Instruction *> work{};
+    for (auto ins : seeds) {
+        if (in_list.insert(ins).second)
+            work.push_back(ins);
+    }
+    seeds = std::move(work);
+    while (not seeds.empty()) {
+        auto ins = seeds.back();
+        seeds.pop_back();
+        in_list.erase(ins);
+        if (not ins->get_use_list().empty() or is_critical(ins))
+            continue;
+        std::vector<Instruction *> ops;
+        for (auto op : ins->get_operands()) {
+            if (auto def = dynamic_cast<Instruction *>(op))
+                ops.push_back(def);
+        }
+        ins->get_parent()->erase_instr(ins);
+        erased++;
+        // 操作数失去最后一个使用者时加入工作表
+        for (auto def : ops) {
+            if (def->get_use_list().empty() and in_list.insert(def).second)
+                seeds.push_back(def);
+        }
+    }
+    ins_count += erased;
+    return erased;
+}
+
 bool DeadCode::is_critical(Instruction *ins) {
     // TODO: 判断指令是否是无用指令
     // 提示：
@@ -134,29 +145,12 @@ bool DeadCode::is_critical(Instruction *ins) {
     //     return false;
     // }
 
-    // 3. call 指令可能有副作用（如IO），通常视为关键的
+    // 3. call 指令可能有副作用（如IO），只读且不会终止程序的函数调用不是关键的
     if (auto func_call = dynamic_cast<CallInst*>(ins)) {
-        return not this->func_info->is_pure_function(func_call->get_function());
+        auto callee = static_cast<Function *>(func_call->get_operand(0));
+        return this->func_info->has_side_effect(callee);
     }
     
     // 其他指令（如 add, sub, mul 等纯计算指令）默认不是关键的
     return false;
 }
-
-void DeadCode::sweep_globally() {
-    std::vector<Function *> unused_funcs;
-    std::vector<GlobalVariable *> unused_globals;
-    for (auto &f_r : m_->get_functions()) {
-        if (f_r.get_use_list().size() == 0 and f_r.get_name() != "main")
-            unused_funcs.push_back(&f_r);
-    }
-    for (auto &glob_var_r : m_->get_global_variable()) {
-        if (glob_var_r.get_use_list().size() == 0)
-            unused_globals.push_back(&glob_var_r);
-    }
-    // changed |= unused_funcs.size() or unused_globals.size();
-    for (auto func : unused_funcs)
-        m_->get_functions().erase(func);
-    for (auto glob : unused_globals)
-        m_->get_global_variable().erase(glob);
-}
@@ -0,0 +1,202 @@
+#include "DeadStoreElimination.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Module.hpp"
+#include "logging.hpp"
+
+void DeadStoreElimination::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        func_ = &func;
+        run_on_function();
+    }
+    LOG_INFO << "dead store elimination erased " << erased_count_
+             << " stores";
+}
+
+DeadStoreElimination::MemLoc DeadStoreElimination::get_location(Value *ptr) {
+    if (dynamic_cast<AllocaInst *>(ptr) or dynamic_cast<GlobalVariable *>(ptr))
+        return {ptr, 0};
+    auto gep = dynamic_cast<GetElementPtrInst *>(ptr);
+    if (gep == nullptr)
+        return {nullptr, -1};
+    auto base = gep->get_operand(0);
+    if (not dynamic_cast<AllocaInst *>(base) and
+        not dynamic_cast<GlobalVariable *>(base))
+        return {nullptr, -1};
+    if (gep->get_num_operand() != 3)
+        return {base, -1};
+    auto first = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+    auto idx = dynamic_cast<ConstantInt *>(gep->get_operand(2));
+    if (first == nullptr or first->get_value() != 0 or idx == nullptr or
+        idx->get_value() < 0)
+        return {base, -1};
+    return {base, idx->get_value()};
+}
+
+// 检查地址的所有使用：只作为 load/store 的地址或 gep 的基址时不逃逸
+void DeadStoreElimination::analyze_base(Value *base) {
+    bool read = false;
+    std::vector<Value *> work_list{base};
+    while (not work_list.empty()) {
+        auto ptr = work_list.back();
+        work_list.pop_back();
+        for (auto &use : ptr->get_use_list()) {
+            auto instr = dynamic_cast<Instruction *>(use.val_);
+            if (instr == nullptr) {
+                escaped_.insert(base);
+            } else if (instr->is_load()) {
+                read = true;
+            } else if (instr->is_store() and use.arg_no_ == 1) {
+                continue;
+            } else if (instr->is_gep() and use.arg_no_ == 0) {
+                work_list.push_back(instr);
+            } else {
+                escaped_.insert(base);
+            }
+        }
+    }
+    if (not read)
+        unread_.insert(base);
+}
+
+void DeadStoreElimination::collect_locations() {
+    loc_id_.clear();
+    loc_base_.clear();
+    escaped_.clear();
+    unread_.clear();
+    for (auto &instr : func_->get_entry_block()->get_instructions()) {
+        if (instr.is_alloca())
+            analyze_base(&instr);
+    }
+    for (auto &bb : func_->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (not instr.is_store())
+                continue;
+            auto loc = get_location(instr.get_operand(1));
+            if (loc.base == nullptr or loc.offset < 0)
+                continue;
+            auto key = std::make_pair(loc.base, loc.offset);
+            if (loc_id_.count(key))
+                continue;
+            loc_id_[key] = loc_base_.size();
+            loc_base_.push_back(loc.base);
+        }
+    }
+}
+
+// 被调函数可能读取全局变量和地址已逃逸的局部变量
+bool DeadStoreElimination::may_be_read_by_call(Value *base) const {
+    return dynamic_cast<GlobalVariable *>(base) or escaped_.count(base);
+}
+
+DeadStoreElimination::State DeadStoreElimination::exit_state() const {
+    bool is_main = func_->get_name() == "main";
+    State state(loc_base_.size(), false);
+    for (unsigned i = 0; i < loc_base_.size(); i++) {
+        if (dynamic_cast<AllocaInst *>(loc_base_[i]) or is_main)
+            state[i] = true;
+    }
+    return state;
+}
+
+void DeadStoreElimination::transfer(Instruction *instr, State &state,
+                                    std::vector<StoreInst *> *dead_stores) {
+    if (instr->is_ret()) {
+        state = exit_state();
+    } else if (instr->is_store()) {
+        auto loc = get_location(instr->get_operand(1));
+        auto it = loc_id_.find({loc.base, loc.offset});
+        if (it == loc_id_.end())
+            return;
+        if (state[it->second] and dead_stores != nullptr)
+            dead_stores->push_back(static_cast<StoreInst *>(instr));
+        state[it->second] = true;
+    } else if (instr->is_load()) {
+        auto loc = get_location(instr->get_operand(0));
+        if (loc.base != nullptr and loc.offset >= 0) {
+            auto it = loc_id_.find({loc.base, loc.offset});
+            if (it != loc_id_.end())
+                state[it->second] = false;
+            return;
+        }
+        for (unsigned i = 0; i < loc_base_.size(); i++) {
+            if (loc.base == nullptr ? may_be_read_by_call(loc_base_[i])
+                                    : loc_base_[i] == loc.base)
+                state[i] = false;
+        }
+    } else if (instr->is_call()) {
+        auto callee = static_cast<Function *>(instr->get_operand(0));
+        // 库函数只做输入输出，不访问程序中的内存
+        if (callee->is_declaration())
+            return;
+        for (unsigned i = 0; i < loc_base_.size(); i++) {
+            if (may_be_read_by_call(loc_base_[i]))
+                state[i] = false;
+        }
+    }
+}
+
+void DeadStoreElimination::solve() {
+    live_in_.clear();
+    for (auto &bb : func_->get_basic_blocks())
+        live_in_[&bb] = State(loc_base_.size(), true);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = func_->get_basic_blocks().rbegin();
+             it != func_->get_basic_blocks().rend(); ++it) {
+            auto bb = &*it;
+            // 出口处的集合为所有后继入口集合的交集
+            State state(loc_base_.size(), true);
+            for (auto succ : bb->get_succ_basic_blocks()) {
+                auto &in = live_in_[succ];
+                for (unsigned i = 0; i < state.size(); i++)
+                    state[i] = state[i] and in[i];
+            }
+            auto &instrs = bb->get_instructions();
+            for (auto instr = instrs.rbegin(); instr != instrs.rend(); ++instr)
+                transfer(&*instr, state, nullptr);
+            if (state != live_in_[bb]) {
+                live_in_[bb] = state;
+                changed = true;
+            }
+        }
+    }
+}
+
+void DeadStoreElimination::run_on_function() {
+    collect_locations();
+    std::vector<StoreInst *> dead_stores;
+    if (not loc_base_.empty()) {
+        solve();
+        for (auto &bb : func_->get_basic_blocks()) {
+            State state(loc_base_.size(), true);
+            for (auto succ : bb.get_succ_basic_blocks()) {
+                auto &in = live_in_[succ];
+                for (unsigned i = 0; i < state.size(); i++)
+                    state[i] = state[i] and in[i];
+            }
+            auto &instrs = bb.get_instructions();
+            for (auto instr = instrs.rbegin(); instr != instrs.rend(); ++instr)
+                transfer(&*instr, state, &dead_stores);
+        }
+    }
+    // 从未被读取且没有逃逸的局部数组，任何下标的写入都是无用的
+    for (auto &bb : func_->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (not instr.is_store())
+                continue;
+            auto loc = get_location(instr.get_operand(1));
+            if (loc.base != nullptr and loc.offset < 0 and
+                unread_.count(loc.base) and not escaped_.count(loc.base))
+                dead_stores.push_back(static_cast<StoreInst *>(&instr));
+        }
+    }
+    for (auto store : dead_stores) {
+        store->get_parent()->erase_instr(store);
+        erased_count_++;
+    }
+}
@@ -69,15 +69,16 @@ void Dominators::create_idom(Function *f) {
                 continue;
             if (bb->get_pre_basic_blocks().empty())
                 continue;
-            BasicBlock *first_pred = bb->get_pre_basic_blocks().front();
-            BasicBlock *new_idom = first_pred;
+            // 从已经算出 idom 的前驱出发，回边的源可能尚未处理
+            BasicBlock *new_idom = nullptr;
             for (auto &pred : bb->get_pre_basic_blocks()) {
-                if (pred == first_pred)
+                if (get_idom(pred) == nullptr)
                     continue;
-                if (get_idom(pred) != nullptr) {
-                    new_idom = intersect(pred, new_idom);
-                }
+                new_idom =
+                    new_idom == nullptr ? pred : intersect(pred, new_idom);
             }
+            if (new_idom == nullptr)
+                continue;
             if (new_idom != get_idom(bb)) {
                 changed = true;
                 idom_[bb] = new_idom;
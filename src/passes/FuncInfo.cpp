@@ -1,110 +1,139 @@
 #include "FuncInfo.hpp"
 #include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
 
 void FuncInfo::run() {
-    for (auto &f : m_->get_functions()) {
-        auto func = &f;
-        trivial_mark(func);
-        if (not is_pure[func])
-            worklist.push_back(func);
+    call_graph_->run();
+    mod_ref_.clear();
+    for (auto &scc : call_graph_->get_sccs()) {
+        for (auto func : scc) {
+            auto &summary = mod_ref_[func];
+            auto num_args = func->get_num_of_args();
+            summary.reads_arg.assign(num_args, false);
+            summary.writes_arg.assign(num_args, false);
+        }
+        // 摘要只会增大，分量内的递归调用迭代到不动点即可
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto func : scc) {
+                auto summary = compute(func);
+                if (summary != mod_ref_[func]) {
+                    mod_ref_[func] = summary;
+                    changed = true;
+                }
+            }
+        }
     }
-    while (worklist.empty() == false) {
-        auto now = worklist.front();
-        worklist.pop_front();
-        process(now);
+    for (auto &[func, summary] : mod_ref_) {
+        LOG_DEBUG << func->get_name() << ": readnone " << is_readnone(func)
+                  << ", readonly " << is_readonly(func);
     }
-    log();
 }
 
-void FuncInfo::log() {
-    for (auto it : is_pure) {
-        LOG_INFO << it.first->get_name() << " is pure? " << it.second;
+bool FuncInfo::is_readnone(Function *func) const {
+    auto &summary = mod_ref_.at(func);
+    if (not is_readonly(func) or summary.reads_global)
+        return false;
+    for (auto reads : summary.reads_arg) {
+        if (reads)
+            return false;
     }
+    return true;
 }
 
-// 有 store 操作的函数非纯函数来处理
-void FuncInfo::trivial_mark(Function *func) {
-    if (func->is_declaration() or func->get_name() == "main") {
-        is_pure[func] = false;
-        return;
-    }
-    // 只要传入数组，都作为非纯函数处理
-    for (auto it = func->get_function_type()->param_begin();
-         it != func->get_function_type()->param_end(); ++it) {
-        auto arg_type = *it;
-        if (arg_type->is_integer_type() == false and
-            arg_type->is_float_type() == false) {
-            is_pure[func] = false;
-            return;
-        }
-    }
-    for (auto &bb : func->get_basic_blocks())
-        for (auto &inst : bb.get_instructions()) {
-            if (is_side_effect_inst(&inst)) {
-                is_pure[func] = false;
-                return;
-            }
-        }
-    is_pure[func] = true;
+bool FuncInfo::has_side_effect(Function *func) const {
+    return not is_readonly(func) or mod_ref_.at(func).may_exit;
 }
 
-void FuncInfo::process(Function *func) {
-    for (auto &use : func->get_use_list()) {
-        LOG_INFO << use.val_->print() << " uses func: " << func->get_name();
-        if (auto inst = dynamic_cast<Instruction *>(use.val_)) {
-            auto func = (inst->get_parent()->get_parent());
-            if (is_pure[func]) {
-                is_pure[func] = false;
-                worklist.push_back(func);
-            }
-        } else
-            LOG_WARNING << "Value besides instruction uses a function";
+bool FuncInfo::is_readonly(Function *func) const {
+    auto &summary = mod_ref_.at(func);
+    if (summary.io or summary.writes_global)
+        return false;
+    for (auto writes : summary.writes_arg) {
+        if (writes)
+            return false;
     }
+    return true;
 }
 
-// 对局部变量进行 store 没有副作用
-bool FuncInfo::is_side_effect_inst(Instruction *inst) {
-    if (inst->is_store()) {
-        if (is_local_store(dynamic_cast<StoreInst *>(inst)))
-            return false;
-        return true;
+FuncInfo::ModRef FuncInfo::compute(Function *func) {
+    ModRef summary;
+    summary.reads_arg.assign(func->get_num_of_args(), false);
+    summary.writes_arg.assign(func->get_num_of_args(), false);
+    if (func->is_declaration()) {
+        // 数组下标检查失败时终止程序，不访问内存也不算 I/O
+        if (func->get_name() == "neg_idx_except")
+            summary.may_exit = true;
+        else
+            summary.io = true;
+        return summary;
     }
-    if (inst->is_load()) {
-        if (is_local_load(dynamic_cast<LoadInst *>(inst)))
-            return false;
-        return true;
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (instr.is_load()) {
+                add_access(summary, func, get_base(instr.get_operand(0)), false);
+            } else if (instr.is_store()) {
+                add_access(summary, func, get_base(instr.get_operand(1)), true);
+            } else if (instr.is_call()) {
+                auto callee = static_cast<Function *>(instr.get_operand(0));
+                auto &callee_summary = mod_ref_[callee];
+                summary.io |= callee_summary.io;
+                summary.may_exit |= callee_summary.may_exit;
+                summary.reads_global |= callee_summary.reads_global;
+                summary.writes_global |= callee_summary.writes_global;
+                // 被调函数通过指针形参的读写落到实参所指的对象上
+                for (unsigned i = 0; i < callee_summary.reads_arg.size(); i++) {
+                    auto base = get_base(instr.get_operand(i + 1));
+                    if (callee_summary.reads_arg[i])
+                        add_access(summary, func, base, false);
+                    if (callee_summary.writes_arg[i])
+                        add_access(summary, func, base, true);
+                }
+            }
+        }
     }
-    // call 指令的副作用会在后续 bfs 中计算
-    return false;
+    return summary;
 }
 
-bool FuncInfo::is_local_load(LoadInst *inst) {
-    auto addr =
-        dynamic_cast<Instruction *>(get_first_addr(inst->get_operand(0)));
-    if (addr and addr->is_alloca())
-        return true;
-    return false;
+void FuncInfo::add_access(ModRef &summary, Function *func, Value *base,
+                          bool write) {
+    if (auto instr = dynamic_cast<Instruction *>(base)) {
+        if (instr->is_alloca())
+            return;
+    }
+    if (dynamic_cast<GlobalVariable *>(base)) {
+        (write ? summary.writes_global : summary.reads_global) = true;
+        return;
+    }
+    if (auto arg = dynamic_cast<Argument *>(base)) {
+        auto &args = write ? summary.writes_arg : summary.reads_arg;
+        args[arg->get_arg_no()] = true;
+        return;
+    }
+    // 无法确定访问对象时，按可能访问全局变量和任一指针形参处理
+    (write ? summary.writes_global : summary.reads_global) = true;
+    auto &args = write ? summary.writes_arg : summary.reads_arg;
+    for (auto &arg : func->get_args()) {
+        if (arg.get_type()->is_pointer_type())
+            args[arg.get_arg_no()] = true;
+    }
 }
 
-bool FuncInfo::is_local_store(StoreInst *inst) {
-    auto addr = dynamic_cast<Instruction *>(get_first_addr(inst->get_lval()));
-    if (addr and addr->is_alloca())
-        return true;
-    return false;
-}
-Value *FuncInfo::get_first_addr(Value *val) {
-    if (auto inst = dynamic_cast<Instruction *>(val)) {
-        if (inst->is_alloca())
-            return inst;
-        if (inst->is_gep())
-            return get_first_addr(inst->get_operand(0));
-        if (inst->is_load())
-            return val;
-        LOG_WARNING << "FuncInfo: try to determine addr in operands";
-        for (auto op : inst->get_operands()) {
-            if (op->get_type()->is_pointer_type())
-                return get_first_addr(op);
-        }
+Value *FuncInfo::get_base(Value *addr) {
+    while (true) {
+        if (dynamic_cast<GlobalVariable *>(addr) or
+            dynamic_cast<Argument *>(addr))
+            return addr;
+        auto instr = dynamic_cast<Instruction *>(addr);
+        if (instr == nullptr)
+            return nullptr;
+        if (instr->is_alloca())
+            return instr;
+        if (not instr->is_gep())
+            return nullptr;
+        addr = instr->get_operand(0);
     }
-    return val;
 }
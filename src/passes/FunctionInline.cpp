@@ -1,204 +1,228 @@
-#include "../../include/passes/FunctionInline.hpp"
-#include "../../include/lightir/Function.hpp"
-
+#include "FunctionInline.hpp"
 #include "BasicBlock.hpp"
+#include "CloneUtils.hpp"
+#include "Function.hpp"
 #include "Instruction.hpp"
 #include "Value.hpp"
 #include "logging.hpp"
-#include <cassert>
-#include <utility>
+
+#include <algorithm>
+#include <set>
 #include <vector>
 
-void FunctionInline::run() { inline_all_functions(); }
-
-void FunctionInline::inline_all_functions() {
-    
-    std::set<Function *> recursive_func;
-    for (auto &func : m_->get_functions()) {
-        for (auto &bb : func.get_basic_blocks()) {
-            for (auto &inst : bb.get_instructions()) {
-                if (inst.is_call()) {
-                    auto call = &inst;
-                    auto func1 = static_cast<Function *>(call->get_operand(0));
-                    if (func1 == &func) {
-                        recursive_func.insert(func1);
-                        break;
-                    }
-                }
-            }
+namespace {
+// 每个常量实参带来的估价减免
+constexpr int const_arg_bonus = 10;
+// 被调函数只有一个调用点时，内联后原函数即可删除
+constexpr int single_call_bonus = 100;
+} // namespace
+
+void FunctionInline::run() {
+    call_graph_->run();
+    growth_.clear();
+    // 被调用者所在的分量先处理，内联进调用者的总是已经内联过的函数体
+    for (auto &scc : call_graph_->get_sccs()) {
+        for (auto func : scc) {
+            if (not func->is_declaration())
+                inline_calls_in(func);
         }
+        if (recursive_depth_ > 0 and scc.size() == 1 and
+            call_graph_->is_recursive(scc.front()))
+            inline_recursive(scc.front());
     }
-    for (auto &func : m_->get_functions()) {
-        if (outside_func.find(func.get_name()) != outside_func.end()) {
+    LOG_INFO << "function inline pass inlined " << inline_count_ << " calls";
+}
+
+void FunctionInline::inline_calls_in(Function *caller) {
+    std::vector<CallInst *> calls;
+    for (auto &bb : caller->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (instr.is_call())
+                calls.push_back(static_cast<CallInst *>(&instr));
+        }
+    }
+    // 内联进来的调用已在处理被调函数时被拒绝过，不再重复考虑
+    for (auto call : calls) {
+        auto callee = static_cast<Function *>(call->get_operand(0));
+        if (not can_inline(call, callee))
+            continue;
+        int cost = get_cost(call, callee);
+        if (cost > threshold_)
+            continue;
+        int size = count_instructions(callee);
+        if (growth_[caller] + size > growth_budget_)
             continue;
+        growth_[caller] += size;
+        inline_function(call, callee);
+        inline_count_++;
+    }
+}
+
+void FunctionInline::inline_recursive(Function *func) {
+    if (not can_inline_recursive(func))
+        return;
+    // 展开过程中函数体不断变化，每层都复制展开前的函数体
+    auto snapshot = clone_function(func, func->get_name() + "_rec");
+    int size = count_instructions(snapshot);
+    // 因预算不足而保留的调用点，之后各层不再考虑
+    std::set<CallInst *> kept;
+    for (int depth = 0; depth < recursive_depth_; depth++) {
+        std::vector<CallInst *> calls;
+        for (auto &bb : func->get_basic_blocks()) {
+            for (auto &instr : bb.get_instructions()) {
+                if (instr.is_call() and instr.get_operand(0) == func and
+                    not kept.count(static_cast<CallInst *>(&instr)))
+                    calls.push_back(static_cast<CallInst *>(&instr));
+            }
         }
-    a1:
-        for (auto &bb : func.get_basic_blocks()) {
-            for (auto &inst : bb.get_instructions()) {
-                if (inst.is_call()) {
-                    auto call = &inst;
-                    auto func1 = static_cast<Function *>(call->get_operand(0));
-                    if (func1 == &func) {
-                        continue;
-                    }
-                    if (recursive_func.find(func1) != recursive_func.end())
-                        continue;
-                    if (outside_func.find(func1->get_name()) !=
-                        outside_func.end())
-                        continue;
-                    if(func1->get_basic_blocks().size() >=6){
-                        continue;
-                    }
-                    inline_function(call, func1);
-                    goto a1;
-                }
+        if (calls.empty())
+            break;
+        for (auto call : calls) {
+            if (growth_[func] + size > growth_budget_) {
+                kept.insert(call);
+                continue;
             }
+            growth_[func] += size;
+            inline_function(call, snapshot);
+            inline_count_++;
         }
     }
+
+    // 副本中的调用指向原函数，清空其函数体后删除
+    for (auto &bb : snapshot->get_basic_blocks())
+        bb.erase_instr(bb.get_terminator());
+    for (auto &bb : snapshot->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions())
+            instr.remove_all_operands();
+    }
+    m_->get_functions().erase(snapshot);
 }
 
-void FunctionInline::inline_function(Instruction *call, Function *origin) {
-    std::map<Value *, Value *> v_map;
-    std::vector<BasicBlock *> bb_list;
-    std::vector<Instruction *> ret_list; // 记录函数所有出口
-    for (auto &arg : origin->get_args()) {
-        v_map.insert(std::make_pair(static_cast<Value *>(&arg),
-                                    call->get_operand(arg.get_arg_no() + 1)));
+bool FunctionInline::can_inline_recursive(Function *func) {
+    if (func->is_declaration() or func->get_name() == "main")
+        return false;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (bb.get_terminator()->is_ret())
+            return true;
     }
-    auto call_bb = call->get_parent();
-    auto call_func = call_bb->get_parent();
-    std::vector<BasicBlock *> ret_void_bbs;
-    for (auto &bb : origin->get_basic_blocks()) {
-        auto bb_new =
-            BasicBlock::create(call_func->get_parent(), "", call_func);
-        v_map.insert(std::make_pair(static_cast<Value *>(&bb),
-                                    static_cast<Value *>(bb_new)));
-        bb_list.push_back(bb_new);
-        for (auto &inst : bb.get_instructions()) {
-            if (inst.is_ret() && origin->get_return_type()->is_void_type()) {
-                ret_void_bbs.push_back(bb_new);
-                continue;
-            }
-            if (inst.is_phi()) {
-                ;
-            }
-            
-            Instruction *inst_new ;
-            if (inst.is_call()) {
-                auto call = static_cast<CallInst *>(&inst);
-                auto func = static_cast<Function *>(call->get_operand(0));
-                // 
-                inst_new = new CallInst(func, {call->get_operands().begin() + 1, call->get_operands().end()}, bb_new);
-            }
-            else inst_new = inst.clone(bb_new);
-            // 
-            if (inst.is_phi())
-                bb_new->add_instr_begin(inst_new);
-            v_map.insert(std::make_pair(static_cast<Value *>(&inst),
-                                        static_cast<Value *>(inst_new)));
-            if (inst.is_ret()) {
-                ret_list.push_back(inst_new);
-            }
+    return false;
+}
+
+bool FunctionInline::can_inline(CallInst *call, Function *callee) {
+    auto caller = call->get_function();
+    if (callee->is_declaration())
+        return false;
+    if (callee == caller or call_graph_->in_same_scc(callee, caller))
+        return false;
+    // 没有返回点的函数（死循环）无法提供返回值
+    if (not callee->get_return_type()->is_void_type()) {
+        for (auto &bb : callee->get_basic_blocks()) {
+            if (bb.get_terminator()->is_ret())
+                return true;
         }
+        return false;
+    }
+    return true;
+}
+
+int FunctionInline::count_instructions(Function *func) {
+    int count = 0;
+    for (auto &bb : func->get_basic_blocks())
+        count += bb.get_num_of_instr();
+    return count;
+}
+
+int FunctionInline::get_cost(CallInst *call, Function *callee) {
+    int cost = count_instructions(callee);
+    for (unsigned i = 1; i < call->get_num_operand(); i++) {
+        if (dynamic_cast<Constant *>(call->get_operand(i)))
+            cost -= const_arg_bonus;
     }
-    for (auto bb : bb_list) {
-        for (auto &inst : bb->get_instructions()) {
-            for (int i = 0; i < inst.get_num_operand(); i++) {
-                if (inst.is_phi()) {
-                    ;
-                }
-                auto op = inst.get_operand(i);
-                if (v_map.find(op) != v_map.end()) {
-                    inst.set_operand(i, v_map[op]);
-                }
+    if (call_graph_->get_call_sites(callee).size() == 1)
+        cost -= single_call_bonus;
+    return cost;
+}
+
+BasicBlock *FunctionInline::split_block_after(CallInst *call) {
+    auto bb = call->get_parent();
+    auto func = bb->get_parent();
+    auto next_bb = BasicBlock::create(func->get_parent(), "", func);
+
+    std::vector<Instruction *> moved;
+    bool after_call = false;
+    for (auto &instr : bb->get_instructions()) {
+        if (after_call)
+            moved.push_back(&instr);
+        if (&instr == call)
+            after_call = true;
+    }
+    for (auto instr : moved) {
+        bb->remove_instr(instr);
+        instr->set_parent(next_bb);
+        next_bb->add_instruction(instr);
+    }
+
+    // 后继的前驱以及其中 phi 的来源块都改为后半部分
+    for (auto succ : bb->get_succ_basic_blocks()) {
+        auto &pres = succ->get_pre_basic_blocks();
+        std::replace(pres.begin(), pres.end(), bb, next_bb);
+        next_bb->add_succ_basic_block(succ);
+        for (auto &instr : succ->get_instructions()) {
+            if (not instr.is_phi())
+                break;
+            for (unsigned i = 1; i < instr.get_num_operand(); i += 2) {
+                if (instr.get_operand(i) == bb)
+                    instr.set_operand(i, next_bb);
             }
         }
     }
-    Value *ret_val = nullptr; // 返回值
-    bool is_terminated = false;
-    auto bb_new = BasicBlock::create(call_func->get_parent(), "", call_func);
-    if (!origin->get_return_type()->is_void_type()) {
-        // 
-        if (ret_list.size() == 1) {
-            auto ret = ret_list.front();
-            ret_val = ret->get_operand(0);
-            auto ret_bb = ret->get_parent();
-            ret_bb->remove_instr(ret);
-            BranchInst::create_br(bb_new, ret_bb);
-        } else {
-            // TODO: 处理多个返回值的情况
-            // 提示：
-            // 1. 需要创建一个新的基本块(bb_phi)用于存放phi指令
-            // 2. 对于每个返回指令：
-            //    - 记录其所在的基本块
-            //    - 移除返回指令
-            //    - 添加跳转到bb_phi的分支指令
-            // 3. 创建phi指令：
-            //    - 设置正确的返回类型
-            //    - 为每个返回路径添加phi对
-            // 4. 将phi指令添加到bb_phi
-            // 5. 设置返回值
-            // 6. 将bb_phi添加到基本块列表
-            // 7. 添加从bb_phi到bb_new的跳转
+    bb->get_succ_basic_blocks().clear();
+    return next_bb;
+}
+
+void FunctionInline::inline_function(CallInst *call, Function *origin) {
+    auto call_bb = call->get_parent();
+    auto caller = call_bb->get_parent();
+    auto next_bb = split_block_after(call);
+
+    std::map<Value *, Value *> v_map;
+    unsigned i = 1;
+    for (auto &arg : origin->get_args())
+        v_map[&arg] = call->get_operand(i++);
+    std::vector<std::pair<Value *, BasicBlock *>> ret_vals;
+    auto new_bbs = clone_blocks(origin, caller, v_map, next_bb, &ret_vals);
+
+    // 被调函数的局部变量移到调用者的入口块，避免在循环中重复分配栈空间
+    auto entry = caller->get_entry_block();
+    for (auto bb : new_bbs) {
+        std::vector<Instruction *> allocas;
+        for (auto &instr : bb->get_instructions()) {
+            if (instr.is_alloca())
+                allocas.push_back(&instr);
         }
-    } else {
-        assert(ret_void_bbs.size() > 0);
-        for (auto bb : ret_void_bbs) {
-            BranchInst::create_br(bb_new, bb);
+        for (auto alloca : allocas) {
+            bb->remove_instr(alloca);
+            alloca->set_parent(entry);
+            entry->add_instr_begin(alloca);
         }
     }
-    std::vector<Instruction *> del_list;
-    // 
-    // 
-    BranchInst* br = nullptr;
-    for (auto &inst : call_bb->get_instructions()) {
-    // 
-        if (!is_terminated) {
-            // 如果前一个基本块还没遇到这条跳转指令
-            if (&(inst) == call) {
-                
-                
-                br = BranchInst::create_br(bb_list.front(), call_bb);
-                // bb_1->add_instruction(br);
-                // call_bb->insert_before(&inst, br);
-                // inst.replace_all_use_with(br);
-                if (!origin->get_return_type()->is_void_type()) {
-                    // 
-                    // auto temp = call->get_use_list().begin();
-                    call->replace_all_use_with(ret_val);
-                    // 
-                    // 
-
-                }
-                // call_bb->remove_instr(call);
-                // del_list.push_back(call);
-                is_terminated = true;
-            }
-        } else {
-            // call_bb->remove_instr(&inst);
-            if(dynamic_cast<BranchInst*>(&inst) == br){
-                continue;
+
+    // 返回指令已改为跳转到调用点之后的块，多个返回点在该块中用 phi 合并返回值
+    if (not call->is_void() and not ret_vals.empty()) {
+        Value *ret_val = ret_vals.front().first;
+        if (ret_vals.size() > 1) {
+            std::vector<Value *> vals;
+            std::vector<BasicBlock *> bbs;
+            for (auto &[val, bb] : ret_vals) {
+                vals.push_back(val);
+                bbs.push_back(bb);
             }
-            del_list.push_back(&inst);
+            auto phi = PhiInst::create_phi(call->get_type(), next_bb, vals, bbs);
+            next_bb->add_instr_begin(phi);
+            ret_val = phi;
         }
+        call->replace_all_use_with(ret_val);
     }
-    // 
-    call_bb->remove_instr(call);
-    origin->remove_use(call, 0);
-    // 
-    for (auto inst : del_list) {
-        
-        call_bb->remove_instr(inst);
-        bb_new->add_instruction(inst);
-        inst->set_parent(bb_new);
-    }
-
-    // 
-    // br->set_parent(call_bb);
-    // 
-    origin->reset_bbs();
-    // 
-    call_func->reset_bbs();
-    
-    return;
-}
\ No newline at end of file
+    call_bb->erase_instr(call);
+    BranchInst::create_br(new_bbs.front(), call_bb);
+}
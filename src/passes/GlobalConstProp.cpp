@@ -0,0 +1,144 @@
+#include "GlobalConstProp.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "Module.hpp"
+#include "logging.hpp"
+
+#include <set>
+
+void GlobalConstProp::run() {
+    main_func_ = nullptr;
+    for (auto &func : m_->get_functions()) {
+        if (func.get_name() == "main")
+            main_func_ = &func;
+    }
+    if (main_func_ == nullptr)
+        return;
+    call_graph_->run();
+    // 支配树的计算要求没有不可达的前驱
+    main_func_->remove_unreachable_bbs();
+    dominators_ = std::make_unique<Dominators>(m_);
+    dominators_->run_on_func(main_func_);
+
+    // 被替换的读取先保留，全部处理完后连同地址计算一起删除
+    std::vector<Instruction *> dead;
+    for (auto &global : m_->get_global_variable()) {
+        std::vector<LoadInst *> loads;
+        std::vector<StoreInst *> stores;
+        if (not collect_accesses(&global, loads, stores) or loads.empty())
+            continue;
+        Constant *val = nullptr;
+        auto ty = global.get_type()->get_pointer_element_type();
+        if (stores.empty()) {
+            // 从未写入：读取的都是初值，零初值按读取的类型取零
+            auto init = global.get_init();
+            if (dynamic_cast<ConstantZero *>(init) == nullptr) {
+                if (ty->is_array_type())
+                    continue;
+                val = init;
+            }
+        } else if (stores.size() == 1 and not ty->is_array_type()) {
+            val = dynamic_cast<Constant *>(stores.front()->get_rval());
+            if (val == nullptr or not store_precedes_loads(stores.front(), loads))
+                continue;
+        } else {
+            continue;
+        }
+        for (auto load : loads) {
+            auto c = val != nullptr ? val : get_zero(load->get_type());
+            load->replace_all_use_with(c);
+            dead.push_back(load);
+            replaced_count_++;
+        }
+        // 已没有读取，写入也不再有意义
+        for (auto store : stores) {
+            if (auto ptr = dynamic_cast<Instruction *>(store->get_lval()))
+                dead.push_back(ptr);
+            store->get_parent()->erase_instr(store);
+        }
+    }
+    dce_->erase_trivially_dead(dead);
+    LOG_INFO << "global const prop replaced " << replaced_count_ << " loads";
+}
+
+bool GlobalConstProp::collect_accesses(GlobalVariable *global,
+                                       std::vector<LoadInst *> &loads,
+                                       std::vector<StoreInst *> &stores) {
+    std::vector<Value *> work_list{global};
+    while (not work_list.empty()) {
+        auto ptr = work_list.back();
+        work_list.pop_back();
+        for (auto &use : ptr->get_use_list()) {
+            auto instr = dynamic_cast<Instruction *>(use.val_);
+            if (instr == nullptr)
+                return false;
+            if (instr->is_load())
+                loads.push_back(static_cast<LoadInst *>(instr));
+            else if (instr->is_store() and use.arg_no_ == 1)
+                stores.push_back(static_cast<StoreInst *>(instr));
+            else if (instr->is_gep() and use.arg_no_ == 0)
+                work_list.push_back(instr);
+            else
+                // 地址被传入函数等，可能在别处被写入
+                return false;
+        }
+    }
+    return true;
+}
+
+Constant *GlobalConstProp::get_zero(Type *ty) {
+    if (ty->is_float_type())
+        return ConstantFP::get(0.0f, m_);
+    return ConstantInt::get(0, m_);
+}
+
+bool GlobalConstProp::dominates(Instruction *def, Instruction *use) {
+    auto def_bb = def->get_parent();
+    auto use_bb = use->get_parent();
+    if (def_bb != use_bb)
+        return dominators_->is_dominate(def_bb, use_bb);
+    for (auto &instr : def_bb->get_instructions()) {
+        if (&instr == def)
+            return true;
+        if (&instr == use)
+            return false;
+    }
+    return false;
+}
+
+bool GlobalConstProp::store_precedes_loads(
+    StoreInst *store, const std::vector<LoadInst *> &loads) {
+    if (store->get_function() != main_func_ or
+        not call_graph_->get_callers(main_func_).empty())
+        return false;
+    std::set<Function *> readers;
+    for (auto load : loads) {
+        if (load->get_function() == main_func_) {
+            if (not dominates(store, load))
+                return false;
+        } else {
+            readers.insert(load->get_function());
+        }
+    }
+    if (readers.empty())
+        return true;
+    // 其他函数中的读取只能经由 main 中的调用发生，这些调用都必须在写入之后
+    for (auto &bb : main_func_->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (not instr.is_call())
+                continue;
+            auto callee = static_cast<Function *>(instr.get_operand(0));
+            if (callee->is_declaration())
+                continue;
+            auto reachable = call_graph_->get_reachable(callee);
+            bool reads = false;
+            for (auto f : readers)
+                reads |= reachable.count(f) > 0;
+            if (reads and not dominates(store, &instr))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+#include "GlobalDCE.hpp"
+#include "DeadCode.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "Module.hpp"
+#include "logging.hpp"
+
+void GlobalDCE::run() {
+    remove_dead_functions();
+
+    // 删除返回值后，只用于计算返回值的参数也会变为无用，因此迭代至不动点
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        call_graph_->run();
+        std::vector<Function *> funcs;
+        for (auto &func : m_->get_functions()) {
+            if (not func.is_declaration() and func.get_name() != "main")
+                funcs.push_back(&func);
+        }
+        for (auto func : funcs)
+            changed |= shrink_signature(func);
+        if (changed)
+            DeadCode(m_).run();
+    }
+
+    remove_dead_globals();
+    LOG_INFO << "global dce removed " << func_count_ << " functions, "
+             << global_count_ << " globals, " << arg_count_ << " arguments, "
+             << ret_count_ << " return values";
+}
+
+void GlobalDCE::remove_dead_functions() {
+    Function *main_func = nullptr;
+    for (auto &func : m_->get_functions()) {
+        if (func.get_name() == "main")
+            main_func = &func;
+    }
+    if (main_func == nullptr)
+        return;
+    call_graph_->run();
+    auto reachable = call_graph_->get_reachable(main_func);
+    std::vector<Function *> dead;
+    for (auto &func : m_->get_functions()) {
+        if (not reachable.count(&func))
+            dead.push_back(&func);
+    }
+    // 不可达的函数之间可能互相调用，先清空所有函数体再删除函数
+    for (auto func : dead) {
+        for (auto &bb : func->get_basic_blocks()) {
+            if (bb.is_terminated())
+                bb.erase_instr(bb.get_terminator());
+        }
+        for (auto &bb : func->get_basic_blocks()) {
+            for (auto &instr : bb.get_instructions())
+                instr.remove_all_operands();
+        }
+    }
+    for (auto func : dead) {
+        m_->get_functions().erase(func);
+        func_count_++;
+    }
+}
+
+void GlobalDCE::remove_dead_globals() {
+    std::vector<GlobalVariable *> dead;
+    for (auto &global : m_->get_global_variable()) {
+        if (global.get_use_list().empty())
+            dead.push_back(&global);
+    }
+    for (auto global : dead) {
+        m_->get_global_variable().erase(global);
+        global_count_++;
+    }
+}
+
+bool GlobalDCE::shrink_signature(Function *func) {
+    auto &call_sites = call_graph_->get_call_sites(func);
+    std::vector<bool> keep_arg;
+    std::vector<Type *> param_types;
+    for (auto &arg : func->get_args()) {
+        keep_arg.push_back(not arg.get_use_list().empty());
+        if (keep_arg.back())
+            param_types.push_back(arg.get_type());
+    }
+    bool drop_ret = not func->get_return_type()->is_void_type();
+    for (auto call : call_sites) {
+        if (not call->get_use_list().empty())
+            drop_ret = false;
+    }
+    if (param_types.size() == keep_arg.size() and not drop_ret)
+        return false;
+
+    // 按新的签名创建函数，并把原函数的基本块整体移动过去
+    auto ret_ty = drop_ret ? m_->get_void_type() : func->get_return_type();
+    auto new_func = Function::create(
+        m_->get_function_type(ret_ty, param_types), func->get_name(), m_);
+    // 保持函数在模块中的原有顺序
+    m_->get_functions().remove(new_func);
+    m_->get_functions().insert(func->getIterator(), new_func);
+    auto &new_bbs = new_func->get_basic_blocks();
+    new_bbs.splice(new_bbs.end(), func->get_basic_blocks());
+    for (auto &bb : new_bbs)
+        bb.set_parent(new_func);
+    auto new_arg = new_func->get_args().begin();
+    for (auto &arg : func->get_args()) {
+        if (arg.get_use_list().empty())
+            continue;
+        arg.replace_all_use_with(&*new_arg);
+        ++new_arg;
+    }
+    if (drop_ret) {
+        for (auto &bb : new_bbs) {
+            auto ret = bb.get_terminator();
+            if (not ret->is_ret())
+                continue;
+            bb.erase_instr(ret);
+            ReturnInst::create_void_ret(&bb);
+        }
+        ret_count_++;
+    }
+
+    // 改写调用点，只传入保留下来的参数
+    std::vector<CallInst *> calls(call_sites.begin(), call_sites.end());
+    for (auto call : calls) {
+        std::vector<Value *> args;
+        for (unsigned i = 0; i < keep_arg.size(); i++) {
+            if (keep_arg[i])
+                args.push_back(call->get_operand(i + 1));
+        }
+        auto bb = call->get_parent();
+        auto new_call = CallInst::create_call(new_func, args, bb);
+        bb->remove_instr(new_call);
+        bb->insert_before(call->getIterator(), new_call);
+        call->replace_all_use_with(new_call);
+        bb->erase_instr(call);
+    }
+    arg_count_ += keep_arg.size() - param_types.size();
+    m_->get_functions().erase(func);
+    return true;
+}
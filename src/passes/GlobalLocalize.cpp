@@ -0,0 +1,87 @@
+#include "GlobalLocalize.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "Module.hpp"
+#include "logging.hpp"
+
+#include <vector>
+
+void GlobalLocalize::run() {
+    call_graph_->run();
+    std::vector<std::pair<GlobalVariable *, Function *>> candidates;
+    for (auto &global : m_->get_global_variable()) {
+        auto func = get_only_user(&global);
+        if (func != nullptr)
+            candidates.push_back({&global, func});
+    }
+    for (auto [global, func] : candidates) {
+        localize(global, func);
+    }
+    LOG_INFO << "global localize pass localized " << localized_count_
+             << " globals";
+}
+
+Function *GlobalLocalize::get_only_user(GlobalVariable *global) {
+    auto ty = global->get_type()->get_pointer_element_type();
+    if (not ty->is_integer_type() and not ty->is_float_type())
+        return nullptr;
+    Function *func = nullptr;
+    for (auto &use : global->get_use_list()) {
+        auto instr = dynamic_cast<Instruction *>(use.val_);
+        if (instr == nullptr)
+            return nullptr;
+        // 全局变量只能作为 load/store 的地址出现
+        if (not instr->is_load() and
+            not(instr->is_store() and use.arg_no_ == 1))
+            return nullptr;
+        if (func != nullptr and instr->get_function() != func)
+            return nullptr;
+        func = instr->get_function();
+    }
+    if (func == nullptr or call_graph_->is_recursive(func))
+        return nullptr;
+    return func;
+}
+
+void GlobalLocalize::localize(GlobalVariable *global, Function *func) {
+    auto entry = func->get_entry_block();
+    auto ty = global->get_type()->get_pointer_element_type();
+    auto local = AllocaInst::create_alloca(ty, entry);
+    global->replace_all_use_with(local);
+
+    // 在入口块开头初始化局部变量
+    Value *init = global->get_init();
+    bool is_main = func->get_name() == "main";
+    if (not is_main)
+        init = LoadInst::create_load(global, entry);
+    auto store = StoreInst::create_store(init, local, entry);
+    entry->remove_instr(store);
+    entry->add_instr_begin(store);
+    if (not is_main) {
+        auto load = static_cast<Instruction *>(init);
+        entry->remove_instr(load);
+        entry->add_instr_begin(load);
+    }
+    entry->remove_instr(local);
+    entry->add_instr_begin(local);
+
+    if (is_main) {
+        // main 只会执行一次，局部化后全局变量不再有用
+        m_->get_global_variable().erase(global);
+    } else {
+        // 其他函数在每个出口写回，保证下一次调用能读到最新值
+        for (auto &bb : func->get_basic_blocks()) {
+            auto term = bb.get_terminator();
+            if (not term->is_ret())
+                continue;
+            auto load = LoadInst::create_load(local, &bb);
+            auto write_back = StoreInst::create_store(load, global, &bb);
+            bb.remove_instr(load);
+            bb.remove_instr(write_back);
+            bb.insert_before(term->getIterator(), load);
+            bb.insert_before(term->getIterator(), write_back);
+        }
+    }
+    localized_count_++;
+}
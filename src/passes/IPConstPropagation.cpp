@@ -0,0 +1,188 @@
+#include "IPConstPropagation.hpp"
+#include "BasicBlock.hpp"
+#include "CloneUtils.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+#include <string>
+
+void IPConstPropagation::run() {
+    if (specialize_)
+        specialize_functions();
+
+    Function *main_func = nullptr;
+    for (auto &func : m_->get_functions()) {
+        if (func.get_name() == "main")
+            main_func = &func;
+    }
+    if (main_func == nullptr)
+        return;
+    mark_block(main_func->get_entry_block());
+    bool changed = true;
+    while (changed) {
+        solve();
+        changed = false;
+        for (auto &func : m_->get_functions()) {
+            if (not func.is_declaration())
+                changed |= resolve_undef_branches(&func);
+        }
+    }
+
+    // 从未被执行到的函数保持原样，交由全局死代码消除处理
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration() or
+            not executable_bbs_.count(func.get_entry_block()))
+            continue;
+        for (auto &arg : func.get_args()) {
+            auto val = get_lattice(&arg);
+            if (val.is_constant())
+                arg.replace_all_use_with(val.value);
+        }
+        folded_count_ += rewrite(&func);
+    }
+    LOG_INFO << "ipsccp folded " << folded_count_ << " instructions, created "
+             << spec_count_ << " specializations";
+}
+
+ConstPropagation::LatticeVal IPConstPropagation::get_lattice(Value *val) {
+    if (dynamic_cast<Argument *>(val) == nullptr)
+        return ConstPropagation::get_lattice(val);
+    auto it = lattice_.find(val);
+    if (it == lattice_.end())
+        return {};
+    return it->second;
+}
+
+void IPConstPropagation::visit_call(CallInst *call) {
+    auto callee = static_cast<Function *>(call->get_operand(0));
+    if (callee->is_declaration()) {
+        ConstPropagation::visit_call(call);
+        return;
+    }
+    unsigned i = 1;
+    for (auto &arg : callee->get_args())
+        merge_lattice(&arg, get_lattice(call->get_operand(i++)));
+    mark_block(callee->get_entry_block());
+    // 函数的返回值格值记录在函数本身上
+    if (not call->is_void()) {
+        auto it = lattice_.find(callee);
+        if (it != lattice_.end())
+            merge_lattice(call, it->second);
+    }
+}
+
+void IPConstPropagation::visit_ret(ReturnInst *ret) {
+    if (ret->is_void_ret())
+        return;
+    merge_lattice(ret->get_function(), get_lattice(ret->get_operand(0)));
+}
+
+std::vector<bool> IPConstPropagation::get_spec_args(Function *func) {
+    std::vector<bool> spec_args;
+    for (auto &arg : func->get_args()) {
+        auto ty = arg.get_type();
+        spec_args.push_back(ty->is_integer_type() or ty->is_float_type());
+    }
+    for (auto call : call_graph_->get_call_sites(func)) {
+        if (call->get_function() != func)
+            continue;
+        unsigned i = 0;
+        for (auto &arg : func->get_args()) {
+            if (call->get_operand(i + 1) != &arg)
+                spec_args[i] = false;
+            i++;
+        }
+    }
+    return spec_args;
+}
+
+IPConstPropagation::SpecKey
+IPConstPropagation::get_spec_key(CallInst *call,
+                                 const std::vector<bool> &spec_args) {
+    SpecKey key;
+    for (unsigned i = 0; i < spec_args.size(); i++) {
+        auto c = dynamic_cast<Constant *>(call->get_operand(i + 1));
+        key.push_back(spec_args[i] ? c : nullptr);
+    }
+    return key;
+}
+
+Function *IPConstPropagation::specialize(Function *func, const SpecKey &key) {
+    auto name = func->get_name() + "_spec" + std::to_string(spec_count_++);
+    auto spec = clone_function(func, name);
+    unsigned i = 0;
+    for (auto &arg : spec->get_args()) {
+        if (key[i] != nullptr)
+            arg.replace_all_use_with(key[i]);
+        i++;
+    }
+    // 副本中原样传递参数的自递归调用现在也带着相同的常量，改为调用副本
+    auto spec_args = get_spec_args(func);
+    for (auto &bb : spec->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (not instr.is_call() or instr.get_operand(0) != func)
+                continue;
+            auto call = static_cast<CallInst *>(&instr);
+            if (get_spec_key(call, spec_args) == key)
+                call->set_operand(0, spec);
+        }
+    }
+    return spec;
+}
+
+void IPConstPropagation::specialize_functions() {
+    call_graph_->run();
+    std::vector<Function *> funcs;
+    for (auto &func : m_->get_functions()) {
+        if (not func.is_declaration() and func.get_name() != "main")
+            funcs.push_back(&func);
+    }
+    for (auto func : funcs) {
+        // 只处理自递归，互相递归的函数不做特化
+        auto &callees = call_graph_->get_callees(func);
+        if (std::any_of(callees.begin(), callees.end(), [&](Function *f) {
+                return f != func and call_graph_->in_same_scc(f, func);
+            }))
+            continue;
+        auto spec_args = get_spec_args(func);
+        if (std::none_of(spec_args.begin(), spec_args.end(),
+                         [](bool b) { return b; }))
+            continue;
+
+        // 外部调用点按常量实参组合分组
+        std::vector<SpecKey> keys;
+        std::map<SpecKey, std::vector<CallInst *>> groups;
+        bool has_plain_call = false;
+        for (auto call : call_graph_->get_call_sites(func)) {
+            if (call->get_function() == func)
+                continue;
+            auto key = get_spec_key(call, spec_args);
+            if (std::all_of(key.begin(), key.end(),
+                            [](Constant *c) { return c == nullptr; })) {
+                has_plain_call = true;
+                continue;
+            }
+            if (not groups.count(key))
+                keys.push_back(key);
+            groups[key].push_back(call);
+        }
+        // 所有调用点一致时过程间传播即可得到常量，无需复制
+        if (keys.empty() or (keys.size() == 1 and not has_plain_call))
+            continue;
+
+        int cost = 0;
+        for (auto &bb : func->get_basic_blocks())
+            cost += bb.get_num_of_instr();
+        int num = 0;
+        for (auto &key : keys) {
+            if (num >= max_spec_per_func or spec_cost_ + cost > spec_budget)
+                break;
+            auto spec = specialize(func, key);
+            for (auto call : groups[key])
+                call->set_operand(0, spec);
+            spec_cost_ += cost;
+            num++;
+        }
+    }
+}
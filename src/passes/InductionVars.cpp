@@ -0,0 +1,165 @@
+#include "InductionVars.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+void InductionVars::run() {
+    basic_ivs_.clear();
+    affine_ivs_.clear();
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        loop_info_->run_on_func(&func);
+        for (auto loop : loop_info_->get_loops_inner_first(&func))
+            run_on_loop(loop);
+    }
+}
+
+bool InductionVars::is_invariant(Loop *loop, Value *val) {
+    auto instr = dynamic_cast<Instruction *>(val);
+    return instr == nullptr or not loop->contains(instr->get_parent());
+}
+
+void InductionVars::run_on_loop(Loop *loop) {
+    auto &basic_ivs = basic_ivs_[loop];
+    auto &affine_ivs = affine_ivs_[loop];
+    basic_ivs.clear();
+    affine_ivs.clear();
+    auto preheader = loop->get_preheader();
+    auto latch = loop->get_latch();
+    if (preheader == nullptr or latch == nullptr)
+        return;
+
+    for (auto &instr : loop->get_header()->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        if (not phi->get_type()->is_int32_type())
+            continue;
+        auto pairs = phi->get_phi_pairs();
+        if (pairs.size() != 2)
+            continue;
+        Value *init = nullptr;
+        Value *next = nullptr;
+        for (auto [val, bb] : pairs) {
+            if (bb == preheader)
+                init = val;
+            else if (bb == latch)
+                next = val;
+        }
+        auto next_instr = dynamic_cast<Instruction *>(next);
+        if (init == nullptr or next_instr == nullptr or not next_instr->is_add())
+            continue;
+        Value *step = nullptr;
+        if (next_instr->get_operand(0) == phi)
+            step = next_instr->get_operand(1);
+        else if (next_instr->get_operand(1) == phi)
+            step = next_instr->get_operand(0);
+        if (step == nullptr or not is_invariant(loop, step))
+            continue;
+        basic_ivs.push_back({phi, init, step, next_instr});
+        affine_ivs[phi] = {phi, 1, nullptr};
+    }
+    if (basic_ivs.empty())
+        return;
+
+    // 循环体按块顺序可能先于操作数出现，迭代到不再有新的仿射值
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto bb : loop->get_blocks()) {
+            for (auto &instr : bb->get_instructions()) {
+                if (affine_ivs.count(&instr))
+                    continue;
+                AffineIV res;
+                if (get_affine(loop, &instr, res)) {
+                    affine_ivs[&instr] = res;
+                    changed = true;
+                }
+            }
+        }
+    }
+    LOG_DEBUG << "loop at " << loop->get_header()->get_name() << " has "
+              << basic_ivs.size() << " basic and " << affine_ivs.size()
+              << " affine induction variables";
+}
+
+Value *InductionVars::add_offset(Value *lhs, Value *rhs) {
+    if (lhs == nullptr)
+        return rhs;
+    if (rhs == nullptr)
+        return lhs;
+    auto lhs_const = dynamic_cast<ConstantInt *>(lhs);
+    auto rhs_const = dynamic_cast<ConstantInt *>(rhs);
+    if (lhs_const == nullptr or rhs_const == nullptr)
+        return nullptr;
+    return ConstantInt::get(static_cast<int>(
+                                static_cast<unsigned>(lhs_const->get_value()) +
+                                static_cast<unsigned>(rhs_const->get_value())),
+                            m_);
+}
+
+bool InductionVars::get_affine(Loop *loop, Instruction *instr, AffineIV &res) {
+    if (not instr->is_add() and not instr->is_sub() and not instr->is_mul())
+        return false;
+    auto &affine_ivs = affine_ivs_[loop];
+    auto lhs = instr->get_operand(0);
+    auto rhs = instr->get_operand(1);
+    auto lhs_iv = affine_ivs.find(lhs);
+    auto rhs_iv = affine_ivs.find(rhs);
+
+    if (instr->is_add()) {
+        // iv + inv 或 inv + iv
+        if (lhs_iv == affine_ivs.end()) {
+            std::swap(lhs, rhs);
+            std::swap(lhs_iv, rhs_iv);
+        }
+        if (lhs_iv == affine_ivs.end() or not is_invariant(loop, rhs))
+            return false;
+        auto offset = add_offset(lhs_iv->second.offset, rhs);
+        if (offset == nullptr)
+            return false;
+        res = {lhs_iv->second.basic, lhs_iv->second.scale, offset};
+        return true;
+    }
+
+    auto rhs_const = dynamic_cast<ConstantInt *>(rhs);
+    if (instr->is_sub()) {
+        // iv - c
+        if (lhs_iv == affine_ivs.end() or rhs_const == nullptr)
+            return false;
+        auto neg = ConstantInt::get(
+            static_cast<int>(0u - static_cast<unsigned>(rhs_const->get_value())),
+            m_);
+        auto offset = add_offset(lhs_iv->second.offset, neg);
+        if (offset == nullptr)
+            return false;
+        res = {lhs_iv->second.basic, lhs_iv->second.scale, offset};
+        return true;
+    }
+
+    // iv * c 或 c * iv，offset 也要乘上 c，因此只能为空或常量
+    if (lhs_iv == affine_ivs.end()) {
+        std::swap(lhs, rhs);
+        std::swap(lhs_iv, rhs_iv);
+        rhs_const = dynamic_cast<ConstantInt *>(rhs);
+    }
+    if (lhs_iv == affine_ivs.end() or rhs_const == nullptr)
+        return false;
+    auto factor = static_cast<unsigned>(rhs_const->get_value());
+    Value *offset = lhs_iv->second.offset;
+    if (offset != nullptr) {
+        auto offset_const = dynamic_cast<ConstantInt *>(offset);
+        if (offset_const == nullptr)
+            return false;
+        offset = ConstantInt::get(
+            static_cast<int>(static_cast<unsigned>(offset_const->get_value()) *
+                             factor),
+            m_);
+    }
+    res = {lhs_iv->second.basic,
+           static_cast<int>(static_cast<unsigned>(lhs_iv->second.scale) * factor),
+           offset};
+    return true;
+}
@@ -0,0 +1,238 @@
+#include "InstSimplify.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <cstring>
+#include <deque>
+#include <set>
+
+namespace {
+
+bool is_int_const(Value *val, int c) {
+    auto ci = dynamic_cast<ConstantInt *>(val);
+    return ci and ci->get_value() == c;
+}
+
+// 浮点常量按位比较，以区分 0.0 与 -0.0
+bool is_fp_const(Value *val, float c) {
+    auto cf = dynamic_cast<ConstantFP *>(val);
+    if (cf == nullptr)
+        return false;
+    float v = cf->get_value();
+    return std::memcmp(&v, &c, sizeof(float)) == 0;
+}
+
+Value *simplify_int_binary(Instruction *instr, Module *m) {
+    auto lhs = instr->get_operand(0);
+    auto rhs = instr->get_operand(1);
+    switch (instr->get_instr_type()) {
+    case Instruction::add:
+        if (is_int_const(rhs, 0))
+            return lhs;
+        if (is_int_const(lhs, 0))
+            return rhs;
+        break;
+    case Instruction::sub:
+        if (is_int_const(rhs, 0))
+            return lhs;
+        if (lhs == rhs)
+            return ConstantInt::get(0, m);
+        break;
+    case Instruction::mul:
+        if (is_int_const(rhs, 1))
+            return lhs;
+        if (is_int_const(lhs, 1))
+            return rhs;
+        if (is_int_const(rhs, 0) or is_int_const(lhs, 0))
+            return ConstantInt::get(0, m);
+        break;
+    case Instruction::sdiv:
+        // x/x 在 x 为 0 时会出错，不做化简
+        if (is_int_const(rhs, 1))
+            return lhs;
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+// 浮点恒等式只保留对 NaN、无穷与符号零都成立的形式
+Value *simplify_float_binary(Instruction *instr) {
+    auto lhs = instr->get_operand(0);
+    auto rhs = instr->get_operand(1);
+    switch (instr->get_instr_type()) {
+    case Instruction::fadd:
+        if (is_fp_const(rhs, -0.0f))
+            return lhs;
+        if (is_fp_const(lhs, -0.0f))
+            return rhs;
+        break;
+    case Instruction::fsub:
+        if (is_fp_const(rhs, 0.0f))
+            return lhs;
+        break;
+    case Instruction::fmul:
+        if (is_fp_const(rhs, 1.0f))
+            return lhs;
+        if (is_fp_const(lhs, 1.0f))
+            return rhs;
+        break;
+    case Instruction::fdiv:
+        if (is_fp_const(rhs, 1.0f))
+            return lhs;
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+// 值与自身比较
+Value *simplify_self_cmp(Instruction *instr, Module *m) {
+    if (instr->get_operand(0) != instr->get_operand(1))
+        return nullptr;
+    switch (instr->get_instr_type()) {
+    case Instruction::eq:
+    case Instruction::ge:
+    case Instruction::le:
+        return ConstantInt::get(true, m);
+    case Instruction::ne:
+    case Instruction::gt:
+    case Instruction::lt:
+        return ConstantInt::get(false, m);
+    // 浮点比较是无序比较，NaN 与自身的 ueq/uge/ule 也为真，其余结果取决于是否为 NaN
+    case Instruction::feq:
+    case Instruction::fge:
+    case Instruction::fle:
+        return ConstantInt::get(true, m);
+    default:
+        return nullptr;
+    }
+}
+
+// 所有输入都相同的 phi
+Value *simplify_phi(PhiInst *phi) {
+    // 缺少某个前驱的输入时该边上为 undef，不做化简
+    if (phi->get_num_operand() / 2 != phi->get_parent()->get_pre_basic_blocks().size())
+        return nullptr;
+    Value *same = nullptr;
+    for (auto &[val, bb] : phi->get_phi_pairs()) {
+        if (val == phi or val == same)
+            continue;
+        if (same != nullptr)
+            return nullptr;
+        same = val;
+    }
+    return same;
+}
+
+} // namespace
+
+Value *simplify_instruction(Instruction *instr, ConstFolder &folder) {
+    auto m = instr->get_module();
+    // 化简规则只针对标量
+    if (instr->get_type()->is_vector_type())
+        return nullptr;
+    // 所有操作数都是常量时直接折叠
+    std::vector<Constant *> ops;
+    for (auto op : instr->get_operands()) {
+        if (auto c = dynamic_cast<Constant *>(op))
+            ops.push_back(c);
+    }
+    switch (instr->get_instr_type()) {
+    case Instruction::add:
+    case Instruction::sub:
+    case Instruction::mul:
+    case Instruction::sdiv:
+        if (ops.size() == 2)
+            if (auto c = folder.compute(instr, ops))
+                return c;
+        return simplify_int_binary(instr, m);
+    case Instruction::fadd:
+    case Instruction::fsub:
+    case Instruction::fmul:
+    case Instruction::fdiv:
+        if (ops.size() == 2)
+            if (auto c = folder.compute(instr, ops))
+                return c;
+        return simplify_float_binary(instr);
+    case Instruction::ge:
+    case Instruction::gt:
+    case Instruction::le:
+    case Instruction::lt:
+    case Instruction::eq:
+    case Instruction::ne:
+    case Instruction::fge:
+    case Instruction::fgt:
+    case Instruction::fle:
+    case Instruction::flt:
+    case Instruction::feq:
+    case Instruction::fne:
+        if (ops.size() == 2)
+            if (auto c = folder.compute(instr, ops))
+                return c;
+        return simplify_self_cmp(instr, m);
+    case Instruction::zext:
+    case Instruction::fptosi:
+    case Instruction::sitofp:
+        // fptosi(sitofp(x)) 在 |x| > 2^24 时会丢失精度，不视为恒等
+        if (ops.size() == 1)
+            return folder.compute(instr, ops);
+        return nullptr;
+    case Instruction::phi:
+        return simplify_phi(static_cast<PhiInst *>(instr));
+    // 访存、调用与控制流指令没有可化简的形式
+    case Instruction::ret:
+    case Instruction::br:
+    case Instruction::alloca:
+    case Instruction::load:
+    case Instruction::store:
+    case Instruction::call:
+    case Instruction::getelementptr:
+    case Instruction::bitcast:
+    case Instruction::extractelement:
+    case Instruction::insertelement:
+    case Instruction::shufflevector:
+        return nullptr;
+    }
+    return nullptr;
+}
+
+void InstSimplify::run() {
+    for (auto &func : m_->get_functions()) {
+        std::deque<Instruction *> work_list;
+        std::set<Instruction *> in_list;
+        // 已被替换、没有使用者的指令，工作表清空后再删除，避免表中留下已释放的指令
+        std::set<Instruction *> simplified;
+        for (auto &bb : func.get_basic_blocks()) {
+            for (auto &instr : bb.get_instructions()) {
+                work_list.push_back(&instr);
+                in_list.insert(&instr);
+            }
+        }
+        while (not work_list.empty()) {
+            auto instr = work_list.front();
+            work_list.pop_front();
+            in_list.erase(instr);
+            if (simplified.count(instr))
+                continue;
+            auto val = simplify_instruction(instr, folder_);
+            if (val == nullptr)
+                continue;
+            // 使用者可能因此可以继续化简，phi 可能使用自身，自身不再入队
+            for (auto &use : instr->get_use_list()) {
+                auto user = dynamic_cast<Instruction *>(use.val_);
+                if (user and user != instr and in_list.insert(user).second)
+                    work_list.push_back(user);
+            }
+            instr->replace_all_use_with(val);
+            simplified.insert(instr);
+            simplified_count_++;
+        }
+        dce_->erase_trivially_dead({simplified.begin(), simplified.end()});
+    }
+    LOG_INFO << "inst simplify simplified " << simplified_count_
+             << " instructions";
+}
@@ -0,0 +1,88 @@
+#include "LICM.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
+
+void LICM::run() {
+    func_info_->run();
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        loop_simplify_->run_on_func(&func);
+        loop_info_->run_on_func(&func);
+        dominators_ = std::make_unique<Dominators>(m_);
+        dominators_->run_on_func(&func);
+        for (auto loop : loop_info_->get_loops_inner_first(&func))
+            run_on_loop(loop);
+    }
+    LOG_INFO << "licm hoisted " << hoisted_count_ << " instructions";
+}
+
+void LICM::run_on_loop(Loop *loop) {
+    auto preheader = loop->get_preheader();
+    auto term = preheader->get_terminator();
+    // 按支配树先序访问，操作数的定义先于使用被外提
+    for (auto bb : dominators_->get_dom_dfs_order()) {
+        if (not loop->contains(bb))
+            continue;
+        auto &instrs = bb->get_instructions();
+        for (auto it = instrs.begin(); it != instrs.end();) {
+            auto instr = &*it++;
+            if (not can_hoist(instr) or not is_invariant(loop, instr))
+                continue;
+            if (may_trap(instr) and not runs_first(loop, instr))
+                continue;
+            bb->remove_instr(instr);
+            instr->set_parent(preheader);
+            preheader->insert_before(term->getIterator(), instr);
+            hoisted_count_++;
+        }
+    }
+}
+
+bool LICM::is_invariant(Loop *loop, Instruction *instr) {
+    for (auto op : instr->get_operands()) {
+        auto op_instr = dynamic_cast<Instruction *>(op);
+        if (op_instr != nullptr and loop->contains(op_instr->get_parent()))
+            return false;
+    }
+    return true;
+}
+
+bool LICM::can_hoist(Instruction *instr) {
+    if (instr->isBinary() or instr->is_cmp() or instr->is_fcmp() or
+        instr->is_zext() or instr->is_fp2si() or instr->is_si2fp() or
+        instr->is_gep())
+        return true;
+    if (instr->is_call() and not instr->is_void()) {
+        auto callee = static_cast<Function *>(instr->get_operand(0));
+        return not callee->is_declaration() and func_info_->is_readnone(callee);
+    }
+    return false;
+}
+
+bool LICM::may_trap(Instruction *instr) {
+    if (instr->is_div()) {
+        auto divisor = dynamic_cast<ConstantInt *>(instr->get_operand(1));
+        return divisor == nullptr or divisor->get_value() == 0 or
+               divisor->get_value() == -1;
+    }
+    // readnone 不保证被调函数中没有除以 0 或死循环
+    return instr->is_call();
+}
+
+bool LICM::runs_first(Loop *loop, Instruction *instr) {
+    // 循环头之外的块可能在下标检查之后才执行
+    auto header = loop->get_header();
+    if (instr->get_parent() != header)
+        return false;
+    for (auto &prev : header->get_instructions()) {
+        if (&prev == instr)
+            return true;
+        if (prev.is_call())
+            return false;
+    }
+    return false;
+}
@@ -0,0 +1,162 @@
+#include "LoopInfo.hpp"
+#include "Dominators.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+
+bool Loop::contains(const Loop *loop) const {
+    for (; loop != nullptr; loop = loop->parent_) {
+        if (loop == this)
+            return true;
+    }
+    return false;
+}
+
+int Loop::get_depth() const {
+    int depth = 1;
+    for (auto loop = parent_; loop != nullptr; loop = loop->parent_)
+        depth++;
+    return depth;
+}
+
+std::vector<BasicBlock *> Loop::get_latches() const {
+    std::vector<BasicBlock *> latches;
+    for (auto pre : header_->get_pre_basic_blocks()) {
+        if (contains(pre) and
+            std::find(latches.begin(), latches.end(), pre) == latches.end())
+            latches.push_back(pre);
+    }
+    return latches;
+}
+
+BasicBlock *Loop::get_latch() const {
+    auto latches = get_latches();
+    return latches.size() == 1 ? latches.front() : nullptr;
+}
+
+BasicBlock *Loop::get_preheader() const {
+    BasicBlock *preheader = nullptr;
+    for (auto pre : header_->get_pre_basic_blocks()) {
+        if (contains(pre))
+            continue;
+        if (preheader != nullptr and preheader != pre)
+            return nullptr;
+        preheader = pre;
+    }
+    if (preheader == nullptr or preheader->get_succ_basic_blocks().size() != 1)
+        return nullptr;
+    return preheader;
+}
+
+std::vector<BasicBlock *> Loop::get_exiting_blocks() const {
+    std::vector<BasicBlock *> exiting;
+    for (auto bb : blocks_) {
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (not contains(succ)) {
+                exiting.push_back(bb);
+                break;
+            }
+        }
+    }
+    return exiting;
+}
+
+std::vector<BasicBlock *> Loop::get_exit_blocks() const {
+    std::vector<BasicBlock *> exits;
+    for (auto bb : blocks_) {
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (not contains(succ) and
+                std::find(exits.begin(), exits.end(), succ) == exits.end())
+                exits.push_back(succ);
+        }
+    }
+    return exits;
+}
+
+void LoopInfo::run() {
+    loops_.clear();
+    bb_to_loop_.clear();
+    top_loops_.clear();
+    for (auto &func : m_->get_functions()) {
+        if (not func.is_declaration())
+            run_on_func(&func);
+    }
+}
+
+void LoopInfo::clear_func(Function *func) {
+    for (auto &bb : func->get_basic_blocks())
+        bb_to_loop_.erase(&bb);
+    // 旧的 Loop 对象仍保留在 loops_ 中，其他函数的循环不受影响
+    top_loops_[func].clear();
+}
+
+void LoopInfo::run_on_func(Function *func) {
+    clear_func(func);
+    auto dominators = std::make_unique<Dominators>(m_);
+    dominators->run_on_func(func);
+
+    // 支配树后序中，内层循环头先于外层循环头出现
+    std::vector<Loop *> loops;
+    for (auto header : dominators->get_dom_post_order()) {
+        std::vector<BasicBlock *> work_list;
+        for (auto pre : header->get_pre_basic_blocks()) {
+            if (dominators->is_dominate(header, pre))
+                work_list.push_back(pre);
+        }
+        if (work_list.empty())
+            continue;
+
+        loops_.push_back(std::make_unique<Loop>(header));
+        auto loop = loops_.back().get();
+        loop->blocks_.push_back(header);
+        loop->block_set_.insert(header);
+        // 从回边源逆着控制流找到循环体，内层循环已确定的块属于其最外层未归属的循环
+        while (not work_list.empty()) {
+            auto bb = work_list.back();
+            work_list.pop_back();
+            if (loop->block_set_.count(bb))
+                continue;
+            loop->blocks_.push_back(bb);
+            loop->block_set_.insert(bb);
+            if (auto inner = get_loop_for(bb)) {
+                while (inner->parent_ != nullptr)
+                    inner = inner->parent_;
+                if (inner != loop) {
+                    inner->parent_ = loop;
+                    loop->sub_loops_.push_back(inner);
+                }
+            } else {
+                bb_to_loop_[bb] = loop;
+            }
+            for (auto pre : bb->get_pre_basic_blocks())
+                work_list.push_back(pre);
+        }
+        bb_to_loop_[header] = loop;
+        loops.push_back(loop);
+    }
+
+    for (auto loop : loops) {
+        if (loop->parent_ == nullptr)
+            top_loops_[func].push_back(loop);
+    }
+    LOG_DEBUG << func->get_name() << " has " << loops.size() << " loops";
+}
+
+std::vector<Loop *> LoopInfo::get_loops_inner_first(Function *func) {
+    std::vector<Loop *> order;
+    std::vector<std::pair<Loop *, bool>> stack;
+    for (auto loop : top_loops_[func])
+        stack.push_back({loop, false});
+    while (not stack.empty()) {
+        auto [loop, visited] = stack.back();
+        stack.pop_back();
+        if (visited) {
+            order.push_back(loop);
+            continue;
+        }
+        stack.push_back({loop, true});
+        for (auto sub : loop->sub_loops_)
+            stack.push_back({sub, false});
+    }
+    return order;
+}
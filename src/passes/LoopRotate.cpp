@@ -0,0 +1,169 @@
+#include "LoopRotate.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <map>
+#include <vector>
+
+void LoopRotate::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        // 旋转会删除原循环头，每次旋转后重新分析
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            loop_simplify_->run_on_func(&func);
+            loop_info_->run_on_func(&func);
+            for (auto loop : loop_info_->get_loops_inner_first(&func)) {
+                if (not can_rotate(loop))
+                    continue;
+                rotate(loop);
+                func.remove_unreachable_bbs();
+                rotated_count_++;
+                changed = true;
+                break;
+            }
+        }
+    }
+    LOG_INFO << "loop rotate rotated " << rotated_count_ << " loops";
+}
+
+bool LoopRotate::can_rotate(Loop *loop) {
+    auto header = loop->get_header();
+    auto latch = loop->get_latch();
+    if (loop->get_preheader() == nullptr or latch == nullptr or latch == header)
+        return false;
+    auto exiting = loop->get_exiting_blocks();
+    if (exiting.size() != 1 or exiting.front() != header)
+        return false;
+
+    auto br = header->get_terminator();
+    if (not br->is_br() or br->get_num_operand() != 3)
+        return false;
+    auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+    if (cmp == nullptr or cmp->get_parent() != header or
+        cmp->get_use_list().size() != 1)
+        return false;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi() and &instr != cmp and &instr != br)
+            return false;
+    }
+    // 判断条件要在保护与 latch 中重算，用到的 phi 不能缺少入口值
+    for (auto op : cmp->get_operands()) {
+        auto phi = dynamic_cast<PhiInst *>(op);
+        if (phi != nullptr and phi->get_parent() == header and
+            phi->get_num_operand() != 4)
+            return false;
+    }
+    // 循环体入口与出口都只从循环头进入
+    for (unsigned i = 1; i <= 2; i++) {
+        auto succ = static_cast<BasicBlock *>(br->get_operand(i));
+        for (auto pre : succ->get_pre_basic_blocks()) {
+            if (pre != header)
+                return false;
+        }
+    }
+    return true;
+}
+
+void LoopRotate::rotate(Loop *loop) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    auto latch = loop->get_latch();
+    auto br = header->get_terminator();
+    auto cmp = static_cast<Instruction *>(br->get_operand(0));
+    auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+    auto body = loop->contains(true_bb) ? true_bb : false_bb;
+    auto exit = loop->contains(true_bb) ? false_bb : true_bb;
+
+    // 循环头 phi 在进入循环时与每次迭代结束时的取值
+    std::map<Value *, Value *> init_map;
+    std::map<Value *, Value *> next_map;
+    std::vector<PhiInst *> phis;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        phis.push_back(phi);
+        for (auto [val, bb] : phi->get_phi_pairs()) {
+            if (bb == preheader)
+                init_map[phi] = val;
+            else
+                next_map[phi] = val;
+        }
+    }
+    // 循环体入口新建 phi，承接原循环头 phi 在每次迭代中的取值
+    std::map<Value *, PhiInst *> body_phis;
+    for (auto it = phis.rbegin(); it != phis.rend(); ++it) {
+        auto body_phi = PhiInst::create_phi((*it)->get_type(), body, {}, {});
+        body->add_instr_begin(body_phi);
+        body_phis[*it] = body_phi;
+    }
+    // 缺少的入口值即 undef，返回 nullptr；latch 取到的循环头 phi 即本次迭代的值
+    auto map_value = [&](std::map<Value *, Value *> &v_map, Value *val) -> Value * {
+        if (not body_phis.count(val))
+            return val;
+        auto it = v_map.find(val);
+        if (it == v_map.end())
+            return nullptr;
+        if (body_phis.count(it->second))
+            return body_phis.at(it->second);
+        return it->second;
+    };
+    auto add_merge_pairs = [&](PhiInst *new_phi, Value *val) {
+        if (auto init = map_value(init_map, val))
+            new_phi->add_phi_pair_operand(init, preheader);
+        if (auto next = map_value(next_map, val))
+            new_phi->add_phi_pair_operand(next, latch);
+    };
+    for (auto phi : phis)
+        add_merge_pairs(body_phis.at(phi), phi);
+
+    // 保护与 latch 中各复制一份判断
+    for (auto [bb, v_map] : {std::make_pair(preheader, &init_map),
+                             std::make_pair(latch, &next_map)}) {
+        bb->erase_instr(bb->get_terminator());
+        auto new_cmp = cmp->clone(bb);
+        for (unsigned i = 0; i < new_cmp->get_num_operand(); i++)
+            new_cmp->set_operand(i, map_value(*v_map, new_cmp->get_operand(i)));
+        BranchInst::create_cond_br(new_cmp, true_bb, false_bb, bb);
+    }
+
+    // 出口块原来只有循环头一个前驱，现在来自保护与 latch
+    for (auto &instr : exit->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        auto val = phi->get_operand(0);
+        phi->remove_phi_operand(header);
+        add_merge_pairs(phi, val);
+    }
+
+    for (auto phi : phis) {
+        // 循环外的使用取出口块中合并的值
+        bool used_outside = false;
+        for (auto &use : phi->get_use_list()) {
+            auto user = static_cast<Instruction *>(use.val_);
+            if (user->get_parent() != header and
+                not loop->contains(user->get_parent()))
+                used_outside = true;
+        }
+        if (used_outside) {
+            auto exit_phi = PhiInst::create_phi(phi->get_type(), exit, {}, {});
+            exit->add_instr_begin(exit_phi);
+            add_merge_pairs(exit_phi, phi);
+            phi->replace_use_with_if(exit_phi, [&](Use *use) {
+                auto user = static_cast<Instruction *>(use->val_);
+                return user->get_parent() != header and
+                       not loop->contains(user->get_parent());
+            });
+        }
+        phi->replace_use_with_if(body_phis.at(phi), [&](Use *use) {
+            return static_cast<Instruction *>(use->val_)->get_parent() != header;
+        });
+    }
+    // 原循环头已没有前驱，由 remove_unreachable_bbs 删除
+}
@@ -0,0 +1,168 @@
+#include "LoopScalarPromotion.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
+
+#include <vector>
+
+void LoopScalarPromotion::run() {
+    func_info_->run();
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        loop_simplify_->run_on_func(&func);
+        loop_info_->run_on_func(&func);
+        // 内层循环先提升，写回与读入落在外层循环中，可继续被外层提升
+        for (auto loop : loop_info_->get_loops_inner_first(&func))
+            run_on_loop(loop);
+    }
+    LOG_INFO << "loop scalar promotion promoted " << promoted_count_
+             << " locations";
+}
+
+LoopScalarPromotion::MemLoc LoopScalarPromotion::get_location(Value *ptr) {
+    if (dynamic_cast<AllocaInst *>(ptr) or dynamic_cast<GlobalVariable *>(ptr))
+        return {ptr, 0};
+    auto gep = dynamic_cast<GetElementPtrInst *>(ptr);
+    if (gep == nullptr)
+        return {nullptr, -1};
+    auto base = gep->get_operand(0);
+    if (not dynamic_cast<AllocaInst *>(base) and
+        not dynamic_cast<GlobalVariable *>(base))
+        return {nullptr, -1};
+    if (gep->get_num_operand() != 3)
+        return {base, -1};
+    auto first = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+    auto idx = dynamic_cast<ConstantInt *>(gep->get_operand(2));
+    auto array_type = base->get_type()->get_pointer_element_type();
+    if (first == nullptr or first->get_value() != 0 or idx == nullptr or
+        idx->get_value() < 0 or not array_type->is_array_type() or
+        idx->get_value() >=
+            static_cast<int>(
+                static_cast<ArrayType *>(array_type)->get_num_of_elements()))
+        return {base, -1};
+    return {base, idx->get_value()};
+}
+
+bool LoopScalarPromotion::is_array(Value *base) {
+    return base->get_type()->get_pointer_element_type()->is_array_type();
+}
+
+void LoopScalarPromotion::run_on_loop(Loop *loop) {
+    // 每个对象在循环中被访问的位置，以及不能提升的对象
+    std::map<Value *, std::set<int>> locations;
+    std::map<MemLoc, bool> stored;
+    std::set<Value *> blocked;
+    bool unknown_access = false;
+    bool call_touches_global = false;
+
+    auto block_arg_object = [&](Value *ptr) {
+        auto base = get_location(ptr).first;
+        if (base == nullptr)
+            unknown_access = true;
+        else
+            blocked.insert(base);
+    };
+
+    for (auto bb : loop->get_blocks()) {
+        for (auto &instr : bb->get_instructions()) {
+            if (instr.is_load() or instr.is_store()) {
+                auto ptr = instr.get_operand(instr.is_load() ? 0 : 1);
+                auto loc = get_location(ptr);
+                if (loc.first == nullptr) {
+                    unknown_access = true;
+                    continue;
+                }
+                locations[loc.first].insert(loc.second);
+                if (instr.is_store())
+                    stored[loc] = true;
+                else
+                    stored.insert({loc, false});
+            } else if (instr.is_call()) {
+                auto callee = static_cast<Function *>(instr.get_operand(0));
+                auto &summary = func_info_->get_mod_ref(callee);
+                if (summary.reads_global or summary.writes_global)
+                    call_touches_global = true;
+                for (unsigned i = 0; i < summary.reads_arg.size(); i++) {
+                    if (summary.reads_arg[i] or summary.writes_arg[i])
+                        block_arg_object(instr.get_operand(i + 1));
+                }
+            }
+        }
+    }
+
+    for (auto &[base, indices] : locations) {
+        if (blocked.count(base) or indices.size() != 1 or indices.count(-1))
+            continue;
+        // 标量局部变量由 Mem2Reg 处理
+        if (dynamic_cast<AllocaInst *>(base) and not is_array(base))
+            continue;
+        // 指针形参只能指向数组，不会与标量重叠
+        if (unknown_access and is_array(base))
+            continue;
+        if (call_touches_global and dynamic_cast<GlobalVariable *>(base))
+            continue;
+        MemLoc loc{base, *indices.begin()};
+        promote(loop, loc, stored[loc]);
+        promoted_count_++;
+    }
+}
+
+void LoopScalarPromotion::promote(Loop *loop, MemLoc loc, bool stored) {
+    auto [base, index] = loc;
+    auto preheader = loop->get_preheader();
+    auto term = preheader->get_terminator();
+    auto func = preheader->get_parent();
+    auto entry = func->get_entry_block();
+
+    // 在前置块中计算地址并读入初值
+    Value *ptr = base;
+    if (is_array(base)) {
+        auto zero = ConstantInt::get(0, m_);
+        auto gep = GetElementPtrInst::create_gep(
+            base, {zero, ConstantInt::get(index, m_)}, preheader);
+        preheader->remove_instr(gep);
+        preheader->insert_before(term->getIterator(), gep);
+        ptr = gep;
+    }
+    auto type = ptr->get_type()->get_pointer_element_type();
+    auto tmp = AllocaInst::create_alloca(type, entry);
+    entry->remove_instr(tmp);
+    entry->add_instr_begin(tmp);
+    auto init = LoadInst::create_load(ptr, preheader);
+    auto init_store = StoreInst::create_store(init, tmp, preheader);
+    for (Instruction *instr : {static_cast<Instruction *>(init),
+                               static_cast<Instruction *>(init_store)}) {
+        preheader->remove_instr(instr);
+        preheader->insert_before(term->getIterator(), instr);
+    }
+
+    // 循环中的访存改为读写临时变量
+    for (auto bb : loop->get_blocks()) {
+        for (auto &instr : bb->get_instructions()) {
+            if (not instr.is_load() and not instr.is_store())
+                continue;
+            unsigned ptr_no = instr.is_load() ? 0 : 1;
+            if (get_location(instr.get_operand(ptr_no)) == loc)
+                instr.set_operand(ptr_no, tmp);
+        }
+    }
+
+    // 出口块的前驱都在循环内，在其开头写回最终值
+    if (not stored)
+        return;
+    for (auto exit : loop->get_exit_blocks()) {
+        auto pos = exit->get_instructions().begin();
+        while (pos->is_phi())
+            ++pos;
+        auto val = LoadInst::create_load(tmp, exit);
+        auto store = StoreInst::create_store(val, ptr, exit);
+        exit->remove_instr(val);
+        exit->insert_before(pos, val);
+        exit->remove_instr(store);
+        exit->insert_before(pos, store);
+    }
+}
@@ -0,0 +1,140 @@
+#include "LoopSimplify.hpp"
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+
+void LoopSimplify::run() {
+    for (auto &func : m_->get_functions()) {
+        if (not func.is_declaration())
+            run_on_func(&func);
+    }
+    LOG_INFO << "loop simplify inserted " << inserted_count_ << " blocks";
+}
+
+bool LoopSimplify::run_on_func(Function *func) {
+    func->remove_unreachable_bbs();
+    bool changed = false;
+    // 每次修改后循环结构可能变化，重新分析直到所有循环都已规范
+    bool again = true;
+    while (again) {
+        again = false;
+        loop_info_->run_on_func(func);
+        for (auto loop : loop_info_->get_loops_inner_first(func)) {
+            if (simplify_loop(loop)) {
+                again = changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+bool LoopSimplify::simplify_loop(Loop *loop) {
+    auto header = loop->get_header();
+
+    if (loop->get_preheader() == nullptr) {
+        std::vector<BasicBlock *> outside;
+        for (auto pre : header->get_pre_basic_blocks()) {
+            if (not loop->contains(pre) and
+                std::find(outside.begin(), outside.end(), pre) == outside.end())
+                outside.push_back(pre);
+        }
+        auto preheader = split_predecessors(header, outside);
+        // 循环头是入口块时，新块成为入口，局部变量的分配随之移动
+        auto func = header->get_parent();
+        if (outside.empty()) {
+            func->get_basic_blocks().remove(preheader);
+            func->get_basic_blocks().push_front(preheader);
+            std::vector<Instruction *> allocas;
+            for (auto &instr : header->get_instructions()) {
+                if (instr.is_alloca())
+                    allocas.push_back(&instr);
+            }
+            for (auto alloca : allocas) {
+                header->remove_instr(alloca);
+                alloca->set_parent(preheader);
+                preheader->add_instr_begin(alloca);
+            }
+        }
+        inserted_count_++;
+        return true;
+    }
+
+    auto latches = loop->get_latches();
+    if (latches.size() > 1) {
+        split_predecessors(header, latches);
+        inserted_count_++;
+        return true;
+    }
+
+    for (auto exit : loop->get_exit_blocks()) {
+        std::vector<BasicBlock *> inside;
+        bool dedicated = true;
+        for (auto pre : exit->get_pre_basic_blocks()) {
+            if (not loop->contains(pre))
+                dedicated = false;
+            else if (std::find(inside.begin(), inside.end(), pre) == inside.end())
+                inside.push_back(pre);
+        }
+        if (dedicated)
+            continue;
+        split_predecessors(exit, inside);
+        inserted_count_++;
+        return true;
+    }
+    return false;
+}
+
+BasicBlock *
+LoopSimplify::split_predecessors(BasicBlock *bb,
+                                 const std::vector<BasicBlock *> &preds) {
+    auto func = bb->get_parent();
+    auto new_bb = BasicBlock::create(func->get_parent(), "", func);
+
+    // bb 中的 phi 把来自 preds 的值移到新块中合并
+    for (auto &instr : bb->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        std::vector<Value *> vals;
+        std::vector<BasicBlock *> bbs;
+        for (auto [val, pre] : phi->get_phi_pairs()) {
+            if (std::find(preds.begin(), preds.end(), pre) != preds.end()) {
+                vals.push_back(val);
+                bbs.push_back(pre);
+            }
+        }
+        if (vals.empty())
+            continue;
+        for (auto pre : bbs)
+            phi->remove_phi_operand(pre);
+        Value *merged = vals.front();
+        if (std::any_of(vals.begin(), vals.end(),
+                        [&](Value *val) { return val != merged; })) {
+            auto new_phi =
+                PhiInst::create_phi(phi->get_type(), new_bb, vals, bbs);
+            new_bb->add_instruction(new_phi);
+            merged = new_phi;
+        }
+        phi->add_phi_pair_operand(merged, new_bb);
+    }
+
+    // 前驱的跳转目标改为新块
+    for (auto pre : preds) {
+        auto br = pre->get_terminator();
+        for (unsigned i = 0; i < br->get_num_operand(); i++) {
+            if (br->get_operand(i) == bb) {
+                br->set_operand(i, new_bb);
+                new_bb->add_pre_basic_block(pre);
+            }
+        }
+        auto &succs = pre->get_succ_basic_blocks();
+        std::replace(succs.begin(), succs.end(), bb, new_bb);
+        bb->remove_pre_basic_block(pre);
+    }
+    BranchInst::create_br(bb, new_bb);
+    return new_bb;
+}
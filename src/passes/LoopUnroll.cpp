@@ -0,0 +1,290 @@
+#include "LoopUnroll.hpp"
+#include "BasicBlock.hpp"
+#include "CloneUtils.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// 循环头 phi 缺少前置块的输入时该值为 undef，展开时取零
+Value *get_undef(Type *ty, Module *m) {
+    if (ty->is_float_type())
+        return ConstantFP::get(0.0f, m);
+    return ConstantInt::get(0, m);
+}
+
+} // namespace
+
+void LoopUnroll::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        loop_simplify_->run_on_func(&func);
+        loop_info_->run_on_func(&func);
+        // 最内层循环互不相交，展开一个不影响其他循环的结构
+        bool changed = false;
+        for (auto loop : loop_info_->get_loops_inner_first(&func)) {
+            if (not loop->get_sub_loops().empty())
+                continue;
+            ExitCond cond;
+            if (not analyze(loop, cond))
+                continue;
+            int size = count_instructions(loop);
+            int trip_count = get_trip_count(cond);
+            if (trip_count >= 0 and trip_count * size <= full_unroll_budget) {
+                full_unroll(loop, cond, trip_count);
+                full_count_++;
+                changed = true;
+                continue;
+            }
+            int factor = unroll_count_;
+            while (factor >= 2 and factor * size > partial_unroll_budget)
+                factor--;
+            if (factor < 2 or cond.pred != Instruction::lt or cond.step <= 0)
+                continue;
+            partial_unroll(loop, cond, factor);
+            partial_count_++;
+            changed = true;
+        }
+        if (changed)
+            func.remove_unreachable_bbs();
+    }
+    LOG_INFO << "loop unroll fully unrolled " << full_count_
+             << " loops, partially unrolled " << partial_count_ << " loops";
+}
+
+int LoopUnroll::count_instructions(Loop *loop) {
+    int count = 0;
+    for (auto bb : loop->get_blocks())
+        count += bb->get_num_of_instr();
+    return count;
+}
+
+bool LoopUnroll::analyze(Loop *loop, ExitCond &cond) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    if (preheader == nullptr or loop->get_latch() == nullptr)
+        return false;
+    auto exiting = loop->get_exiting_blocks();
+    if (exiting.size() != 1 or exiting.front() != header)
+        return false;
+
+    // 循环头只包含 phi、比较和条件跳转
+    auto br = header->get_terminator();
+    if (not br->is_br() or br->get_num_operand() != 3)
+        return false;
+    auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+    if (cmp == nullptr or not cmp->is_cmp() or cmp->get_parent() != header or
+        cmp->get_use_list().size() != 1)
+        return false;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi() and &instr != cmp and &instr != br)
+            return false;
+    }
+
+    ivs_->run_on_loop(loop);
+    const InductionVars::BasicIV *iv = nullptr;
+    bool iv_on_left = true;
+    for (auto &basic : ivs_->get_basic_ivs(loop)) {
+        if (cmp->get_operand(0) == basic.phi) {
+            iv = &basic;
+        } else if (cmp->get_operand(1) == basic.phi) {
+            iv = &basic;
+            iv_on_left = false;
+        }
+    }
+    auto step = iv == nullptr ? nullptr : dynamic_cast<ConstantInt *>(iv->step);
+    if (step == nullptr or step->get_value() == 0)
+        return false;
+    auto bound = cmp->get_operand(iv_on_left ? 1 : 0);
+    if (not InductionVars::is_invariant(loop, bound))
+        return false;
+
+    auto pred = cmp->get_instr_type();
+    if (not iv_on_left) {
+        switch (pred) {
+        case Instruction::lt: pred = Instruction::gt; break;
+        case Instruction::gt: pred = Instruction::lt; break;
+        case Instruction::le: pred = Instruction::ge; break;
+        case Instruction::ge: pred = Instruction::le; break;
+        default: break;
+        }
+    }
+    auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+    if (not loop->contains(true_bb)) {
+        // 条件为假时继续循环，取反
+        switch (pred) {
+        case Instruction::lt: pred = Instruction::ge; break;
+        case Instruction::gt: pred = Instruction::le; break;
+        case Instruction::le: pred = Instruction::gt; break;
+        case Instruction::ge: pred = Instruction::lt; break;
+        case Instruction::eq: pred = Instruction::ne; break;
+        case Instruction::ne: pred = Instruction::eq; break;
+        default: break;
+        }
+        std::swap(true_bb, false_bb);
+    }
+    cond = {iv->phi, iv->init, step->get_value(), pred, bound, true_bb, false_bb};
+    return true;
+}
+
+int LoopUnroll::get_trip_count(const ExitCond &cond) {
+    auto init = dynamic_cast<ConstantInt *>(cond.init);
+    auto bound = dynamic_cast<ConstantInt *>(cond.bound);
+    if (init == nullptr or bound == nullptr)
+        return -1;
+    int64_t iv = init->get_value();
+    int64_t limit = bound->get_value();
+    for (int count = 0; count <= max_full_trip_count; count++) {
+        bool stay = false;
+        switch (cond.pred) {
+        case Instruction::lt: stay = iv < limit; break;
+        case Instruction::le: stay = iv <= limit; break;
+        case Instruction::gt: stay = iv > limit; break;
+        case Instruction::ge: stay = iv >= limit; break;
+        case Instruction::eq: stay = iv == limit; break;
+        case Instruction::ne: stay = iv != limit; break;
+        default: return -1;
+        }
+        if (not stay)
+            return count;
+        iv += cond.step;
+        // 溢出回绕的循环不展开
+        if (iv > INT32_MAX or iv < INT32_MIN)
+            return -1;
+    }
+    return -1;
+}
+
+void LoopUnroll::retarget(BasicBlock *bb, BasicBlock *target) {
+    bb->erase_instr(bb->get_terminator());
+    BranchInst::create_br(target, bb);
+}
+
+std::pair<BasicBlock *, BasicBlock *>
+LoopUnroll::clone_iteration(Loop *loop, const ExitCond &cond,
+                            std::map<PhiInst *, Value *> &vals) {
+    std::map<Value *, Value *> v_map;
+    for (auto &[phi, val] : vals)
+        v_map[phi] = val;
+    clone_region(loop->get_blocks(), v_map);
+    // 副本的循环头只剩判断，不再使用，之后作为不可达块删除
+    auto body = static_cast<BasicBlock *>(v_map.at(cond.body));
+    auto latch = static_cast<BasicBlock *>(v_map.at(loop->get_latch()));
+
+    for (auto &[phi, val] : vals) {
+        for (auto [incoming, bb] : phi->get_phi_pairs()) {
+            if (bb != loop->get_latch())
+                continue;
+            auto it = v_map.find(incoming);
+            val = it == v_map.end() ? incoming : it->second;
+        }
+    }
+    return {body, latch};
+}
+
+void LoopUnroll::full_unroll(Loop *loop, const ExitCond &cond, int trip_count) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    std::map<PhiInst *, Value *> vals;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        vals[phi] = get_undef(phi->get_type(), m_);
+        for (auto [incoming, bb] : phi->get_phi_pairs()) {
+            if (bb == preheader)
+                vals[phi] = incoming;
+        }
+    }
+
+    // 各次迭代的副本首尾相接，最后回到原循环头，此时判断必然不成立
+    auto prev = preheader;
+    for (int i = 0; i < trip_count; i++) {
+        auto [copy_body, copy_latch] = clone_iteration(loop, cond, vals);
+        retarget(prev, copy_body);
+        prev = copy_latch;
+    }
+    if (prev != preheader)
+        retarget(prev, header);
+    for (auto &[phi, val] : vals) {
+        while (phi->get_num_operand() > 0)
+            phi->remove_operand(0);
+        phi->add_phi_pair_operand(val, prev);
+    }
+    // 原循环体不再可达，由 remove_unreachable_bbs 删除
+    retarget(header, cond.exit);
+}
+
+void LoopUnroll::partial_unroll(Loop *loop, const ExitCond &cond, int factor) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    auto func = header->get_parent();
+
+    // guard 计算主循环的上界 n - (factor - 1) * step，减法溢出时直接进入原循环
+    auto guard = BasicBlock::create(m_, "", func);
+    auto main_header = BasicBlock::create(m_, "", func);
+    retarget(preheader, guard);
+    Value *limit = nullptr;
+    int64_t delta = static_cast<int64_t>(factor - 1) * cond.step;
+    auto bound_const = dynamic_cast<ConstantInt *>(cond.bound);
+    if (bound_const != nullptr and bound_const->get_value() - delta >= INT32_MIN) {
+        limit = ConstantInt::get(static_cast<int>(bound_const->get_value() - delta),
+                                 m_);
+        BranchInst::create_br(main_header, guard);
+    } else {
+        limit = IBinaryInst::create_sub(
+            cond.bound, ConstantInt::get(static_cast<int>(delta), m_), guard);
+        auto no_overflow = ICmpInst::create_lt(limit, cond.bound, guard);
+        BranchInst::create_cond_br(no_overflow, main_header, header, guard);
+    }
+
+    // 主循环头：每个原 phi 对应一个新 phi
+    std::map<PhiInst *, Value *> vals;
+    std::map<PhiInst *, PhiInst *> main_phis;
+    std::map<PhiInst *, Value *> inits;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        auto main_phi = PhiInst::create_phi(phi->get_type(), main_header);
+        main_header->add_instruction(main_phi);
+        main_phis[phi] = main_phi;
+        vals[phi] = main_phi;
+        inits[phi] = get_undef(phi->get_type(), m_);
+        for (auto [incoming, bb] : phi->get_phi_pairs()) {
+            if (bb == preheader)
+                inits[phi] = incoming;
+        }
+    }
+    auto in_range = ICmpInst::create_lt(main_phis.at(cond.iv), limit, main_header);
+
+    BasicBlock *first = nullptr;
+    BasicBlock *prev = nullptr;
+    for (int i = 0; i < factor; i++) {
+        auto [copy_body, copy_latch] = clone_iteration(loop, cond, vals);
+        if (prev == nullptr)
+            first = copy_body;
+        else
+            retarget(prev, copy_body);
+        prev = copy_latch;
+    }
+    retarget(prev, main_header);
+    BranchInst::create_cond_br(in_range, first, header, main_header);
+
+    bool guarded = guard->get_succ_basic_blocks().size() == 2;
+    for (auto &[phi, main_phi] : main_phis) {
+        main_phi->add_phi_pair_operand(inits.at(phi), guard);
+        main_phi->add_phi_pair_operand(vals.at(phi), prev);
+        // 剩余迭代从主循环结束时的值开始
+        phi->remove_phi_operand(preheader);
+        phi->add_phi_pair_operand(main_phi, main_header);
+        if (guarded)
+            phi->add_phi_pair_operand(inits.at(phi), guard);
+    }
+}
@@ -0,0 +1,387 @@
+#include "LoopVectorize.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "InductionVars.hpp"
+#include "logging.hpp"
+
+#include <set>
+
+namespace {
+
+void retarget(BasicBlock *bb, BasicBlock *target) {
+    bb->erase_instr(bb->get_terminator());
+    BranchInst::create_br(target, bb);
+}
+
+Instruction *create_binary(Instruction::OpID op, Value *lhs, Value *rhs,
+                           BasicBlock *bb) {
+    switch (op) {
+    case Instruction::add:
+        return IBinaryInst::create_add(lhs, rhs, bb);
+    case Instruction::sub:
+        return IBinaryInst::create_sub(lhs, rhs, bb);
+    case Instruction::mul:
+        return IBinaryInst::create_mul(lhs, rhs, bb);
+    case Instruction::fadd:
+        return FBinaryInst::create_fadd(lhs, rhs, bb);
+    case Instruction::fsub:
+        return FBinaryInst::create_fsub(lhs, rhs, bb);
+    case Instruction::fmul:
+        return FBinaryInst::create_fmul(lhs, rhs, bb);
+    case Instruction::fdiv:
+        return FBinaryInst::create_fdiv(lhs, rhs, bb);
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace
+
+void LoopVectorize::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        // 已处理过的循环头，包括新建的向量循环
+        std::set<BasicBlock *> visited;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            loop_simplify_->run_on_func(&func);
+            loop_info_->run_on_func(&func);
+            for (auto loop : loop_info_->get_loops_inner_first(&func)) {
+                if (not loop->get_sub_loops().empty() or
+                    not visited.insert(loop->get_header()).second)
+                    continue;
+                Plan plan;
+                if (not analyze(loop, plan))
+                    continue;
+                vectorize(loop, plan);
+                vectorized_count_++;
+                changed = true;
+                break;
+            }
+        }
+    }
+    LOG_INFO << "loop vectorize vectorized " << vectorized_count_ << " loops";
+}
+
+bool LoopVectorize::analyze(Loop *loop, Plan &plan) {
+    auto header = loop->get_header();
+    if (loop->get_preheader() == nullptr or loop->get_latch() == nullptr)
+        return false;
+    auto exiting = loop->get_exiting_blocks();
+    auto exits = loop->get_exit_blocks();
+    if (exiting.size() != 1 or exiting.front() != header or exits.size() != 1)
+        return false;
+    for (auto pre : exits.front()->get_pre_basic_blocks()) {
+        if (pre != header)
+            return false;
+    }
+
+    // 循环头只有 phi 与 i < n 的判断
+    auto br = header->get_terminator();
+    if (not br->is_br() or br->get_num_operand() != 3)
+        return false;
+    auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+    if (cmp == nullptr or cmp->get_instr_type() != Instruction::lt or
+        cmp->get_parent() != header or cmp->get_use_list().size() != 1)
+        return false;
+    plan.iv = dynamic_cast<PhiInst *>(cmp->get_operand(0));
+    plan.bound = cmp->get_operand(1);
+    if (plan.iv == nullptr or plan.iv->get_parent() != header or
+        not InductionVars::is_invariant(loop, plan.bound))
+        return false;
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi() and &instr != cmp and &instr != br)
+            return false;
+    }
+    auto body = static_cast<BasicBlock *>(br->get_operand(1));
+    plan.exit = static_cast<BasicBlock *>(br->get_operand(2));
+    if (not loop->contains(body) or loop->contains(plan.exit))
+        return false;
+
+    return collect_body(loop, body, plan) and find_reductions(loop, plan) and
+           check_body(loop, plan);
+}
+
+bool LoopVectorize::collect_body(Loop *loop, BasicBlock *entry, Plan &plan) {
+    auto header = loop->get_header();
+    unsigned count = 1;
+    for (auto bb = entry; bb != header; count++) {
+        if (not loop->contains(bb) or bb->get_pre_basic_blocks().size() != 1)
+            return false;
+        for (auto &instr : bb->get_instructions()) {
+            if (instr.is_phi())
+                return false;
+            if (not instr.isTerminator())
+                plan.body.push_back(&instr);
+        }
+        auto br = bb->get_terminator();
+        if (not br->is_br() or br->get_num_operand() != 1)
+            return false;
+        auto next = static_cast<BasicBlock *>(br->get_operand(0));
+        if (next == header and bb != loop->get_latch())
+            return false;
+        bb = next;
+    }
+    return count == loop->get_blocks().size();
+}
+
+bool LoopVectorize::find_reductions(Loop *loop, Plan &plan) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    auto latch = loop->get_latch();
+    std::set<Instruction *> in_body(plan.body.begin(), plan.body.end());
+    for (auto &instr : header->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        Value *init = nullptr, *next = nullptr;
+        for (auto [val, bb] : phi->get_phi_pairs()) {
+            if (bb == preheader)
+                init = val;
+            else if (bb == latch)
+                next = val;
+        }
+        auto update = dynamic_cast<Instruction *>(next);
+        if (phi->get_num_operand() != 4 or init == nullptr or
+            update == nullptr or not update->is_add() or
+            not in_body.count(update) or update->get_use_list().size() != 1)
+            return false;
+
+        // 归纳变量 i = i + 1
+        if (phi == plan.iv) {
+            if (update->get_operand(0) != phi or
+                update->get_operand(1) != ConstantInt::get(1, m_))
+                return false;
+            plan.init = init;
+            plan.next = update;
+            continue;
+        }
+        // 归约 s = s + x，s 在循环中只用于这次加法
+        Value *operand = nullptr;
+        if (update->get_operand(0) == phi)
+            operand = update->get_operand(1);
+        else if (update->get_operand(1) == phi)
+            operand = update->get_operand(0);
+        if (operand == nullptr or operand == phi)
+            return false;
+        for (auto &use : phi->get_use_list()) {
+            auto user = static_cast<Instruction *>(use.val_);
+            if (user != update and loop->contains(user->get_parent()))
+                return false;
+        }
+        plan.reductions.push_back({phi, init, update, operand});
+    }
+    return plan.next != nullptr;
+}
+
+bool LoopVectorize::is_unit_stride_gep(Loop *loop, PhiInst *iv,
+                                       Instruction *instr) {
+    if (not instr->is_gep())
+        return false;
+    auto ops = instr->get_operands();
+    bool unit_stride =
+        (ops.size() == 2 and ops[1] == iv) or
+        (ops.size() == 3 and ops[1] == ConstantInt::get(0, m_) and
+         ops[2] == iv);
+    auto elem_ty = static_cast<GetElementPtrInst *>(instr)->get_element_type();
+    return unit_stride and InductionVars::is_invariant(loop, ops[0]) and
+           VectorType::is_valid_element_type(elem_ty);
+}
+
+bool LoopVectorize::check_body(Loop *loop, const Plan &plan) {
+    // 可以逐元素计算的值，以及可以整体访问的地址
+    std::set<Value *> lanes, addrs;
+    std::set<Instruction *> updates;
+    for (auto &red : plan.reductions)
+        updates.insert(red.update);
+    auto is_lane_operand = [&](Value *val) {
+        return lanes.count(val) or
+               (val != plan.iv and InductionVars::is_invariant(loop, val));
+    };
+    bool has_memory = false;
+    for (auto instr : plan.body) {
+        if (instr == plan.next)
+            continue;
+        if (updates.count(instr))
+            continue;
+        if (is_unit_stride_gep(loop, plan.iv, instr)) {
+            // 地址只用作访存的指针
+            for (auto &use : instr->get_use_list()) {
+                auto user = static_cast<Instruction *>(use.val_);
+                if (not(user->is_load() or (user->is_store() and use.arg_no_ == 1)))
+                    return false;
+            }
+            addrs.insert(instr);
+        } else if (instr->is_load()) {
+            if (not addrs.count(instr->get_operand(0)))
+                return false;
+            lanes.insert(instr);
+            has_memory = true;
+        } else if (instr->is_store()) {
+            if (not addrs.count(instr->get_operand(1)) or
+                not is_lane_operand(instr->get_operand(0)))
+                return false;
+            has_memory = true;
+        } else if (instr->isBinary() and not instr->is_div()) {
+            if (not is_lane_operand(instr->get_operand(0)) or
+                not is_lane_operand(instr->get_operand(1)))
+                return false;
+            lanes.insert(instr);
+        } else {
+            return false;
+        }
+    }
+    // 归约的操作数在更新之前计算
+    for (auto &red : plan.reductions) {
+        if (not is_lane_operand(red.operand))
+            return false;
+    }
+    // 循环体中定义的值不能在循环体外使用
+    for (auto val : lanes) {
+        for (auto &use : val->get_use_list()) {
+            auto user = static_cast<Instruction *>(use.val_);
+            if (user->is_phi())
+                return false;
+        }
+    }
+    return has_memory;
+}
+
+void LoopVectorize::vectorize(Loop *loop, const Plan &plan) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    auto func = header->get_parent();
+    auto guard = BasicBlock::create(m_, "", func);
+    auto vec_header = BasicBlock::create(m_, "", func);
+    auto vec_body = BasicBlock::create(m_, "", func);
+    auto vec_exit = BasicBlock::create(m_, "", func);
+    retarget(preheader, guard);
+
+    // guard 计算向量循环的上界 n - (vector_width - 1)，减法溢出时直接进入原循环
+    Value *limit = nullptr, *no_overflow = nullptr;
+    int64_t delta = vector_width - 1;
+    auto bound_const = dynamic_cast<ConstantInt *>(plan.bound);
+    if (bound_const != nullptr and
+        bound_const->get_value() - delta >= INT32_MIN) {
+        limit = ConstantInt::get(
+            static_cast<int>(bound_const->get_value() - delta), m_);
+    } else {
+        limit = IBinaryInst::create_sub(
+            plan.bound, ConstantInt::get(static_cast<int>(delta), m_), guard);
+        no_overflow = ICmpInst::create_lt(limit, plan.bound, guard);
+    }
+
+    // 循环不变量在 guard 中展开为各元素相同的向量
+    std::map<Value *, Value *> splats;
+    auto splat = [&](Value *val) {
+        auto &res = splats[val];
+        if (res == nullptr) {
+            auto vec_ty = VectorType::get(val->get_type(), vector_width);
+            auto zero = ConstantZero::get(vec_ty, m_);
+            auto ins = InsertElementInst::create_insertelement(
+                zero, val, ConstantInt::get(0, m_), guard);
+            res = ShuffleVectorInst::create_shufflevector(
+                ins, zero, std::vector<int>(vector_width, 0), guard);
+        }
+        return res;
+    };
+
+    // 向量循环头：归纳变量与各归约的部分和
+    auto vec_iv = PhiInst::create_phi(plan.iv->get_type(), vec_header);
+    vec_header->add_instruction(vec_iv);
+    std::map<PhiInst *, PhiInst *> accs;
+    for (auto &red : plan.reductions) {
+        auto acc = PhiInst::create_phi(
+            VectorType::get(red.phi->get_type(), vector_width), vec_header);
+        vec_header->add_instruction(acc);
+        accs[red.phi] = acc;
+    }
+    auto in_range = ICmpInst::create_lt(vec_iv, limit, vec_header);
+    BranchInst::create_cond_br(in_range, vec_body, vec_exit, vec_header);
+
+    // 向量循环体：每条指令一次处理 vector_width 个元素
+    std::map<Value *, Value *> v_map;
+    auto get_lanes = [&](Value *val) {
+        auto it = v_map.find(val);
+        return it == v_map.end() ? splat(val) : it->second;
+    };
+    for (auto instr : plan.body) {
+        if (instr == plan.next)
+            continue;
+        if (instr->is_gep()) {
+            auto gep = static_cast<GetElementPtrInst *>(instr);
+            std::vector<Value *> idxs;
+            for (unsigned i = 1; i < gep->get_num_operand(); i++) {
+                auto idx = gep->get_operand(i);
+                idxs.push_back(idx == plan.iv ? vec_iv : idx);
+            }
+            auto addr = GetElementPtrInst::create_gep(gep->get_operand(0),
+                                                      idxs, vec_body);
+            auto vec_ty = VectorType::get(gep->get_element_type(), vector_width);
+            v_map[instr] = BitCastInst::create_bitcast(
+                addr, PointerType::get(vec_ty), vec_body);
+        } else if (instr->is_load()) {
+            v_map[instr] =
+                LoadInst::create_load(v_map.at(instr->get_operand(0)), vec_body);
+        } else if (instr->is_store()) {
+            StoreInst::create_store(get_lanes(instr->get_operand(0)),
+                                    v_map.at(instr->get_operand(1)), vec_body);
+        } else {
+            v_map[instr] = create_binary(instr->get_instr_type(),
+                                         get_lanes(instr->get_operand(0)),
+                                         get_lanes(instr->get_operand(1)),
+                                         vec_body);
+        }
+    }
+    std::map<PhiInst *, Value *> acc_nexts;
+    for (auto &red : plan.reductions) {
+        acc_nexts[red.phi] = IBinaryInst::create_add(
+            accs.at(red.phi), get_lanes(red.operand), vec_body);
+    }
+    auto vec_next = IBinaryInst::create_add(
+        vec_iv, ConstantInt::get(vector_width, m_), vec_body);
+    BranchInst::create_br(vec_header, vec_body);
+
+    // 向量循环结束后把部分和的各元素相加，剩余迭代由原循环完成
+    std::map<PhiInst *, Value *> sums;
+    for (auto &red : plan.reductions) {
+        Value *sum = nullptr;
+        for (int i = 0; i < vector_width; i++) {
+            auto elt = ExtractElementInst::create_extractelement(
+                accs.at(red.phi), ConstantInt::get(i, m_), vec_exit);
+            sum = sum == nullptr ? static_cast<Value *>(elt)
+                                 : IBinaryInst::create_add(sum, elt, vec_exit);
+        }
+        sums[red.phi] = sum;
+    }
+    BranchInst::create_br(header, vec_exit);
+
+    vec_iv->add_phi_pair_operand(plan.init, guard);
+    vec_iv->add_phi_pair_operand(vec_next, vec_body);
+    for (auto &red : plan.reductions) {
+        auto vec_ty = accs.at(red.phi)->get_type();
+        auto init = InsertElementInst::create_insertelement(
+            ConstantZero::get(vec_ty, m_), red.init, ConstantInt::get(0, m_),
+            guard);
+        accs.at(red.phi)->add_phi_pair_operand(init, guard);
+        accs.at(red.phi)->add_phi_pair_operand(acc_nexts.at(red.phi), vec_body);
+    }
+    if (no_overflow != nullptr)
+        BranchInst::create_cond_br(no_overflow, vec_header, header, guard);
+    else
+        BranchInst::create_br(vec_header, guard);
+
+    plan.iv->remove_phi_operand(preheader);
+    plan.iv->add_phi_pair_operand(vec_iv, vec_exit);
+    if (no_overflow != nullptr)
+        plan.iv->add_phi_pair_operand(plan.init, guard);
+    for (auto &red : plan.reductions) {
+        red.phi->remove_phi_operand(preheader);
+        red.phi->add_phi_pair_operand(sums.at(red.phi), vec_exit);
+        if (no_overflow != nullptr)
+            red.phi->add_phi_pair_operand(red.init, guard);
+    }
+}
@@ -0,0 +1,229 @@
+#include "LoopVersioning.hpp"
+#include "BasicBlock.hpp"
+#include "CloneUtils.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <map>
+#include <tuple>
+
+namespace {
+
+// scale * r + o 的每个取值都不超出 i32
+bool fits(int scale, const RangeAnalysis::Range &r,
+          const RangeAnalysis::Range &o) {
+    if (r.is_empty() or o.is_empty())
+        return false;
+    auto lo = std::min(scale * r.lo, scale * r.hi) + o.lo;
+    auto hi = std::max(scale * r.lo, scale * r.hi) + o.hi;
+    return lo >= INT_MIN and hi <= INT_MAX;
+}
+
+} // namespace
+
+void LoopVersioning::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        visited_.clear();
+        // 每次版本化后控制流改变，重新分析
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            loop_simplify_->run_on_func(&func);
+            loop_info_->run_on_func(&func);
+            range_->run_on_func(&func);
+            for (auto loop : loop_info_->get_loops_inner_first(&func)) {
+                if (not loop->get_sub_loops().empty() or
+                    not visited_.insert(loop->get_header()).second)
+                    continue;
+                std::vector<Check> checks;
+                if (not analyze(loop, checks))
+                    continue;
+                version(loop, checks);
+                func.remove_unreachable_bbs();
+                versioned_count_++;
+                changed = true;
+                break;
+            }
+        }
+    }
+    LOG_INFO << "loop versioning versioned " << versioned_count_ << " loops";
+}
+
+bool LoopVersioning::analyze(Loop *loop, std::vector<Check> &checks) {
+    auto header = loop->get_header();
+    if (loop->get_preheader() == nullptr or loop->get_latch() == nullptr)
+        return false;
+    auto exiting = loop->get_exiting_blocks();
+    auto exits = loop->get_exit_blocks();
+    if (exiting.size() != 1 or exiting.front() != header or exits.size() != 1)
+        return false;
+    for (auto pre : exits.front()->get_pre_basic_blocks()) {
+        if (pre != header)
+            return false;
+    }
+    int size = 0;
+    for (auto bb : loop->get_blocks())
+        size += bb->get_instructions().size();
+    if (size > version_budget)
+        return false;
+
+    ivs_->run_on_loop(loop);
+    for (auto bb : loop->get_blocks()) {
+        Check check;
+        if (get_check(loop, bb, check))
+            checks.push_back(check);
+    }
+    return not checks.empty();
+}
+
+bool LoopVersioning::get_check(Loop *loop, BasicBlock *bb, Check &check) {
+    auto br = bb->get_terminator();
+    if (not br->is_br() or br->get_num_operand() != 3)
+        return false;
+    auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+    auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+    auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+    if (cmp == nullptr or cmp->get_instr_type() != Instruction::ge or
+        cmp->get_operand(1) != ConstantInt::get(0, m_) or
+        not RangeAnalysis::is_trap_block(false_bb) or
+        RangeAnalysis::is_trap_block(true_bb))
+        return false;
+
+    auto idx = cmp->get_operand(0);
+    if (InductionVars::is_invariant(loop, idx)) {
+        check = {br, true_bb, idx, 1, nullptr};
+        return true;
+    }
+    auto &affine_ivs = ivs_->get_affine_ivs(loop);
+    auto affine = affine_ivs.find(idx);
+    if (affine == affine_ivs.end())
+        return false;
+    auto [phi, scale, offset] = affine->second;
+    const InductionVars::BasicIV *basic = nullptr;
+    for (auto &iv : ivs_->get_basic_ivs(loop)) {
+        if (iv.phi == phi)
+            basic = &iv;
+    }
+    auto step = dynamic_cast<ConstantInt *>(basic->step);
+    // 下标随迭代单调不减时最小值在第一次迭代
+    if (step == nullptr or
+        static_cast<int64_t>(scale) * step->get_value() < 0)
+        return false;
+    // 归纳变量自增不回绕
+    if (range_->get_range(basic->next) == RangeAnalysis::Range::full())
+        return false;
+    // 循环中下标恰为 scale * i + offset，循环前的最小值计算也不溢出
+    auto preheader = loop->get_preheader();
+    auto offset_range = [&](BasicBlock *at) {
+        return offset == nullptr ? RangeAnalysis::Range::point(0)
+                                 : range_->get_range(offset, at);
+    };
+    if (not fits(scale, range_->get_range(phi, bb), offset_range(bb)) or
+        not fits(scale, range_->get_range(basic->init, preheader),
+                 offset_range(preheader)))
+        return false;
+    check = {br, true_bb, basic->init, scale, offset};
+    return true;
+}
+
+void LoopVersioning::version(Loop *loop, const std::vector<Check> &checks) {
+    auto header = loop->get_header();
+    auto preheader = loop->get_preheader();
+    auto exit = loop->get_exit_blocks().front();
+    auto func = header->get_parent();
+
+    std::map<Value *, Value *> v_map;
+    auto copies = clone_region(loop->get_blocks(), v_map);
+    auto copy_header = static_cast<BasicBlock *>(v_map.at(header));
+    std::set<BasicBlock *> copy_set(copies.begin(), copies.end());
+    visited_.insert(copy_header);
+
+    // 前置块中计算各最小下标，依次判断，全部非负时进入副本
+    auto fast = BasicBlock::create(m_, "", func);
+    auto slow = BasicBlock::create(m_, "", func);
+    preheader->erase_instr(preheader->get_terminator());
+    std::map<std::tuple<Value *, int, Value *>, Value *> min_conds;
+    std::vector<Value *> conds;
+    for (auto &check : checks) {
+        auto key = std::make_tuple(check.base, check.scale, check.offset);
+        if (min_conds.count(key))
+            continue;
+        Value *min_idx = check.base;
+        if (check.scale != 1)
+            min_idx = IBinaryInst::create_mul(
+                min_idx, ConstantInt::get(check.scale, m_), preheader);
+        if (check.offset != nullptr)
+            min_idx = IBinaryInst::create_add(min_idx, check.offset, preheader);
+        min_conds[key] =
+            ICmpInst::create_ge(min_idx, ConstantInt::get(0, m_), preheader);
+        conds.push_back(min_conds[key]);
+    }
+    auto cur = preheader;
+    for (unsigned i = 0; i < conds.size(); i++) {
+        auto next =
+            i + 1 == conds.size() ? fast : BasicBlock::create(m_, "", func);
+        BranchInst::create_cond_br(conds[i], next, slow, cur);
+        cur = next;
+    }
+    BranchInst::create_br(copy_header, fast);
+    BranchInst::create_br(header, slow);
+    for (auto [bb, entry] : {std::make_pair(header, slow),
+                             std::make_pair(copy_header, fast)}) {
+        for (auto &instr : bb->get_instructions()) {
+            if (not instr.is_phi())
+                break;
+            auto phi = static_cast<PhiInst *>(&instr);
+            for (auto [val, pre] : phi->get_phi_pairs()) {
+                if (pre != preheader)
+                    continue;
+                phi->remove_phi_operand(preheader);
+                phi->add_phi_pair_operand(val, entry);
+                break;
+            }
+        }
+    }
+
+    // 副本中的检查改为直接跳到访问处
+    for (auto &check : checks) {
+        auto copy_br = static_cast<Instruction *>(v_map.at(check.br));
+        auto copy_bb = copy_br->get_parent();
+        copy_bb->erase_instr(copy_br);
+        BranchInst::create_br(static_cast<BasicBlock *>(v_map.at(check.target)),
+                              copy_bb);
+    }
+
+    // 出口块现在来自两个循环头，循环外的使用取两者合并的值
+    auto map_value = [&](Value *val) {
+        auto it = v_map.find(val);
+        return it == v_map.end() ? val : it->second;
+    };
+    for (auto &instr : exit->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        phi->add_phi_pair_operand(map_value(phi->get_operand(0)), copy_header);
+    }
+    auto is_outside_use = [&](const Use *use) {
+        auto user = static_cast<Instruction *>(use->val_);
+        auto bb = user->get_parent();
+        return not loop->contains(bb) and not copy_set.count(bb) and
+               not(bb == exit and user->is_phi());
+    };
+    for (auto &instr : header->get_instructions()) {
+        bool used_outside = false;
+        for (auto &use : instr.get_use_list()) {
+            if (is_outside_use(&use))
+                used_outside = true;
+        }
+        if (not used_outside)
+            continue;
+        auto exit_phi = PhiInst::create_phi(
+            instr.get_type(), exit, {&instr, v_map.at(&instr)},
+            {header, copy_header});
+        exit->add_instr_begin(exit_phi);
+        instr.replace_use_with_if(exit_phi, is_outside_use);
+    }
+}
@@ -1,6 +1,7 @@
 #include "Mem2Reg.hpp"
 #include "IRBuilder.hpp"
 #include "Value.hpp"
+#include "logging.hpp"
 
 #include <memory>
 
@@ -21,9 +22,13 @@ void Mem2Reg::run() {
             generate_phi();
             // 对应伪代码中重命名阶段
             rename(func_->get_entry_block());
+            // 移除重命名后输入值唯一的冗余 phi
+            remove_trivial_phi();
         }
         // 后续 DeadCode 将移除冗余的局部变量的分配空间
     }
+    LOG_INFO << "mem2reg placed " << phi_count_ << " phis, removed "
+             << trivial_phi_count_ << " trivial phis";
 }
 
 void Mem2Reg::generate_phi() {
@@ -31,6 +36,8 @@ void Mem2Reg::generate_phi() {
     // 步骤一：找到活跃在多个 block 的全局名字集合，以及它们所属的 bb 块
     std::set<Value *> global_live_var_name;
     std::map<Value *, std::set<BasicBlock *>> live_var_2blocks;
+    // 变量在块内先使用后定值（向上暴露的使用）的块
+    std::map<Value *, std::set<BasicBlock *>> var_use_blocks;
     for (auto &bb : func_->get_basic_blocks()) {
         std::set<Value *> var_is_killed;
         for (auto &instr : bb.get_instructions()) {
@@ -41,15 +48,25 @@ void Mem2Reg::generate_phi() {
                 if (is_valid_ptr(l_val)) {
                     global_live_var_name.insert(l_val);
                     live_var_2blocks[l_val].insert(&bb);
+                    var_is_killed.insert(l_val);
+                }
+            } else if (instr.is_load()) {
+                auto l_val = static_cast<LoadInst *>(&instr)->get_lval();
+                if (is_valid_ptr(l_val) and
+                    var_is_killed.find(l_val) == var_is_killed.end()) {
+                    var_use_blocks[l_val].insert(&bb);
                 }
             }
         }
     }
 
     // 步骤二：从支配树获取支配边界信息，并在对应位置插入 phi 指令
+    // 只在变量活跃进入的块中放置 phi（剪枝 SSA）
     std::map<std::pair<BasicBlock *, Value *>, bool>
         bb_has_var_phi; // bb has phi for var
     for (auto var : global_live_var_name) {
+        auto live_in = compute_live_in(var, var_use_blocks[var],
+                                       live_var_2blocks[var]);
         std::vector<BasicBlock *> work_list;
         work_list.assign(live_var_2blocks[var].begin(),
                          live_var_2blocks[var].end());
@@ -57,6 +74,8 @@ void Mem2Reg::generate_phi() {
             auto bb = work_list[i];
             for (auto bb_dominance_frontier_bb :
                  dominators_->get_dominance_frontier(bb)) {
+                if (live_in.find(bb_dominance_frontier_bb) == live_in.end())
+                    continue;
                 if (bb_has_var_phi.find({bb_dominance_frontier_bb, var}) ==
                     bb_has_var_phi.end()) {
                     // generate phi for bb_dominance_frontier_bb & add
@@ -68,12 +87,34 @@ void Mem2Reg::generate_phi() {
                     bb_dominance_frontier_bb->add_instr_begin(phi);
                     work_list.push_back(bb_dominance_frontier_bb);
                     bb_has_var_phi[{bb_dominance_frontier_bb, var}] = true;
+                    phi_count_++;
                 }
             }
         }
     }
 }
 
+std::set<BasicBlock *>
+Mem2Reg::compute_live_in(Value *var, const std::set<BasicBlock *> &use_blocks,
+                         const std::set<BasicBlock *> &def_blocks) {
+    // 从向上暴露使用的块出发沿前驱逆向传播，遇到定值块即停止
+    std::set<BasicBlock *> live_in;
+    std::vector<BasicBlock *> work_list(use_blocks.begin(), use_blocks.end());
+    while (not work_list.empty()) {
+        auto bb = work_list.back();
+        work_list.pop_back();
+        if (not live_in.insert(bb).second)
+            continue;
+        for (auto pre_bb : bb->get_pre_basic_blocks()) {
+            if (def_blocks.find(pre_bb) == def_blocks.end() and
+                live_in.find(pre_bb) == live_in.end()) {
+                work_list.push_back(pre_bb);
+            }
+        }
+    }
+    return live_in;
+}
+
 void Mem2Reg::rename(BasicBlock *bb) {
     // 步骤一：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量
     // alloca出的地址空间 步骤二：用 lval 最新的定值替代对应的load指令
@@ -86,8 +127,9 @@ void Mem2Reg::rename(BasicBlock *bb) {
 
     // 步骤三：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量 alloca
     // 出的地址空间
+    // 之前的运行中已经存在的 phi 不对应任何 lval，直接跳过
     for (auto &instr : bb->get_instructions()) {
-        if (instr.is_phi()) {
+        if (instr.is_phi() and phi_lval.count(static_cast<PhiInst *>(&instr))) {
             auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
             var_val_stack[l_val].push_back(&instr);
         }
@@ -120,7 +162,8 @@ void Mem2Reg::rename(BasicBlock *bb) {
     // 步骤六：为 lval 对应的 phi 指令参数补充完整
     for (auto succ_bb : bb->get_succ_basic_blocks()) {
         for (auto &instr : succ_bb->get_instructions()) {
-            if (instr.is_phi()) {
+            if (instr.is_phi() and
+                phi_lval.count(static_cast<PhiInst *>(&instr))) {
                 auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
                 if (var_val_stack.find(l_val) != var_val_stack.end() &&
                     var_val_stack[l_val].size() != 0) {
@@ -145,7 +188,8 @@ void Mem2Reg::rename(BasicBlock *bb) {
             if (is_valid_ptr(l_val)) {
                 var_val_stack[l_val].pop_back();
             }
-        } else if (instr.is_phi()) {
+        } else if (instr.is_phi() and
+                   phi_lval.count(static_cast<PhiInst *>(&instr))) {
             auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
             if (var_val_stack.find(l_val) != var_val_stack.end()) {
                 var_val_stack[l_val].pop_back();
@@ -158,3 +202,51 @@ void Mem2Reg::rename(BasicBlock *bb) {
         bb->erase_instr(instr);
     }
 }
+
+void Mem2Reg::remove_trivial_phi() {
+    std::vector<PhiInst *> work_list;
+    for (auto &[phi, l_val] : phi_lval) {
+        work_list.push_back(phi);
+    }
+    std::set<PhiInst *> removed;
+    while (not work_list.empty()) {
+        auto phi = work_list.back();
+        work_list.pop_back();
+        if (removed.find(phi) != removed.end())
+            continue;
+        auto phi_bb = phi->get_parent();
+        // 找出除自身以外唯一的输入值，缺失的前驱视作 undef
+        Value *same = nullptr;
+        bool trivial = true;
+        for (auto &[val, pre_bb] : phi->get_phi_pairs()) {
+            if (val == phi or val == same)
+                continue;
+            if (same != nullptr) {
+                trivial = false;
+                break;
+            }
+            same = val;
+        }
+        if (not trivial or same == nullptr)
+            continue;
+        if (phi->get_num_operand() / 2 < phi_bb->get_pre_basic_blocks().size()) {
+            // 存在 undef 输入时，只有在 same 支配 phi 所在块时才能替换
+            auto inst = dynamic_cast<Instruction *>(same);
+            if (inst and
+                not dominators_->is_dominate(inst->get_parent(), phi_bb))
+                continue;
+        }
+        for (auto &use : phi->get_use_list()) {
+            auto user_phi = dynamic_cast<PhiInst *>(use.val_);
+            if (user_phi and user_phi != phi)
+                work_list.push_back(user_phi);
+        }
+        phi->replace_all_use_with(same);
+        removed.insert(phi);
+        phi_bb->erase_instr(phi);
+        trivial_phi_count_++;
+    }
+    for (auto phi : removed) {
+        phi_lval.erase(phi);
+    }
+}
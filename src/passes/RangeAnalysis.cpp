@@ -0,0 +1,340 @@
+#include "RangeAnalysis.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+
+#include <algorithm>
+
+using Range = RangeAnalysis::Range;
+
+namespace {
+
+Instruction::OpID swap_pred(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::lt:
+        return Instruction::gt;
+    case Instruction::le:
+        return Instruction::ge;
+    case Instruction::gt:
+        return Instruction::lt;
+    case Instruction::ge:
+        return Instruction::le;
+    default:
+        return op;
+    }
+}
+
+Instruction::OpID negate_pred(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::lt:
+        return Instruction::ge;
+    case Instruction::le:
+        return Instruction::gt;
+    case Instruction::gt:
+        return Instruction::le;
+    case Instruction::ge:
+        return Instruction::lt;
+    case Instruction::eq:
+        return Instruction::ne;
+    default:
+        return Instruction::eq;
+    }
+}
+
+// 超出 i32 的结果可能回绕，视为任意值
+Range clamp(int64_t lo, int64_t hi) {
+    if (lo < INT_MIN or hi > INT_MAX)
+        return Range::full();
+    return {lo, hi};
+}
+
+} // namespace
+
+Range Range::join(const Range &rhs) const {
+    if (is_empty())
+        return rhs;
+    if (rhs.is_empty())
+        return *this;
+    return {std::min(lo, rhs.lo), std::max(hi, rhs.hi)};
+}
+
+Range Range::meet(const Range &rhs) const {
+    return {std::max(lo, rhs.lo), std::min(hi, rhs.hi)};
+}
+
+void RangeAnalysis::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        run_on_func(&func);
+    }
+}
+
+void RangeAnalysis::run_on_func(Function *func) {
+    ranges_.clear();
+    conds_.clear();
+    update_count_.clear();
+    dominators_ = std::make_unique<Dominators>(m_);
+    dominators_->run_on_func(func);
+    collect_conds(func);
+    collect_thresholds(func);
+
+    // 从空区间出发单调增长直到不动点，支配树先序保证定义先于使用
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto bb : dominators_->get_dom_dfs_order()) {
+            for (auto &instr : bb->get_instructions()) {
+                if (not instr.get_type()->is_int32_type())
+                    continue;
+                auto old_range = get_range(&instr);
+                auto new_range = old_range.join(eval(&instr));
+                if (instr.is_phi() and new_range != old_range and
+                    ++update_count_[&instr] > 2)
+                    new_range = widen(old_range, new_range);
+                if (new_range != old_range) {
+                    ranges_[&instr] = new_range;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+Range RangeAnalysis::get_range(Value *val) {
+    if (auto c = dynamic_cast<ConstantInt *>(val))
+        return Range::point(c->get_value());
+    auto instr = dynamic_cast<Instruction *>(val);
+    if (instr == nullptr or not instr->get_type()->is_int32_type())
+        return Range::full();
+    auto it = ranges_.find(val);
+    return it == ranges_.end() ? Range::empty() : it->second;
+}
+
+Range RangeAnalysis::get_range(Value *val, BasicBlock *bb) {
+    return refine(val, get_range(val), conds_.at(bb));
+}
+
+bool RangeAnalysis::eval_cmp(Instruction *cmp, BasicBlock *bb, bool &res) {
+    if (not cmp->is_cmp())
+        return false;
+    auto op = cmp->get_instr_type();
+    auto lhs = cmp->get_operand(0);
+    auto rhs = cmp->get_operand(1);
+    // 支配处已有相同的比较
+    for (auto [cond, taken] : conds_.at(bb)) {
+        if (cond == cmp or
+            (cond->get_instr_type() == op and cond->get_operand(0) == lhs and
+             cond->get_operand(1) == rhs)) {
+            res = taken;
+            return true;
+        }
+    }
+    auto a = get_range(lhs, bb);
+    auto b = get_range(rhs, bb);
+    if (a.is_empty() or b.is_empty())
+        return false;
+    bool always = false, never = false;
+    switch (op) {
+    case Instruction::lt:
+        always = a.hi < b.lo, never = a.lo >= b.hi;
+        break;
+    case Instruction::le:
+        always = a.hi <= b.lo, never = a.lo > b.hi;
+        break;
+    case Instruction::gt:
+        always = a.lo > b.hi, never = a.hi <= b.lo;
+        break;
+    case Instruction::ge:
+        always = a.lo >= b.hi, never = a.hi < b.lo;
+        break;
+    case Instruction::eq:
+        always = a.lo == a.hi and b.lo == b.hi and a.lo == b.lo;
+        never = a.meet(b).is_empty();
+        break;
+    case Instruction::ne:
+        always = a.meet(b).is_empty();
+        never = a.lo == a.hi and b.lo == b.hi and a.lo == b.lo;
+        break;
+    default:
+        break;
+    }
+    if (always or never)
+        res = always;
+    return always or never;
+}
+
+bool RangeAnalysis::is_trap_block(BasicBlock *bb) {
+    for (auto &instr : bb->get_instructions()) {
+        if (not instr.is_call())
+            continue;
+        auto callee = static_cast<Function *>(instr.get_operand(0));
+        if (callee->get_name() == "neg_idx_except")
+            return true;
+    }
+    return false;
+}
+
+void RangeAnalysis::collect_conds(Function *func) {
+    for (auto bb : dominators_->get_dom_dfs_order()) {
+        if (bb == func->get_entry_block()) {
+            conds_[bb] = {};
+            continue;
+        }
+        auto idom = dominators_->get_idom(bb);
+        conds_[bb] = conds_.at(idom);
+        // 除了不会返回的块外只从 idom 的一条分支进入
+        std::vector<BasicBlock *> preds;
+        for (auto pre : bb->get_pre_basic_blocks()) {
+            if (not is_trap_block(pre))
+                preds.push_back(pre);
+        }
+        std::pair<Instruction *, bool> cond;
+        if (preds.size() == 1 and preds.front() == idom and
+            get_edge_cond(idom, bb, cond))
+            conds_[bb].push_back(cond);
+    }
+}
+
+void RangeAnalysis::collect_thresholds(Function *func) {
+    // 循环条件 i < n 至多把 i 限制在 INT_MAX - 1，保留它使 i + 1 不溢出
+    thresholds_ = {INT_MIN, INT_MIN + 1, INT_MAX - 1, INT_MAX};
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            if (not instr.is_cmp())
+                continue;
+            for (auto op : instr.get_operands()) {
+                if (auto c = dynamic_cast<ConstantInt *>(op)) {
+                    for (int64_t d = -1; d <= 1; d++)
+                        thresholds_.push_back(
+                            std::clamp<int64_t>(c->get_value() + d, INT_MIN,
+                                                INT_MAX));
+                }
+            }
+        }
+    }
+    std::sort(thresholds_.begin(), thresholds_.end());
+}
+
+bool RangeAnalysis::get_edge_cond(BasicBlock *pred, BasicBlock *succ,
+                                  std::pair<Instruction *, bool> &cond) {
+    auto br = pred->get_terminator();
+    if (not br->is_br() or br->get_num_operand() != 3)
+        return false;
+    auto cmp = dynamic_cast<Instruction *>(br->get_operand(0));
+    auto true_bb = br->get_operand(1);
+    auto false_bb = br->get_operand(2);
+    if (cmp == nullptr or not cmp->is_cmp() or true_bb == false_bb)
+        return false;
+    cond = {cmp, true_bb == succ};
+    return true;
+}
+
+Range RangeAnalysis::refine(Value *val, Range range, const CondList &conds) {
+    for (auto [cmp, taken] : conds) {
+        auto op = cmp->get_instr_type();
+        Value *other;
+        if (cmp->get_operand(0) == val) {
+            other = cmp->get_operand(1);
+        } else if (cmp->get_operand(1) == val) {
+            other = cmp->get_operand(0);
+            op = swap_pred(op);
+        } else {
+            continue;
+        }
+        if (other == val)
+            continue;
+        if (not taken)
+            op = negate_pred(op);
+        auto o = get_range(other);
+        if (o.is_empty())
+            return Range::empty();
+        switch (op) {
+        case Instruction::lt:
+            range.hi = std::min(range.hi, o.hi - 1);
+            break;
+        case Instruction::le:
+            range.hi = std::min(range.hi, o.hi);
+            break;
+        case Instruction::gt:
+            range.lo = std::max(range.lo, o.lo + 1);
+            break;
+        case Instruction::ge:
+            range.lo = std::max(range.lo, o.lo);
+            break;
+        case Instruction::eq:
+            range = range.meet(o);
+            break;
+        case Instruction::ne:
+            if (o.lo == o.hi and range.lo == o.lo)
+                range.lo++;
+            if (o.lo == o.hi and range.hi == o.lo)
+                range.hi--;
+            break;
+        default:
+            break;
+        }
+    }
+    return range;
+}
+
+Range RangeAnalysis::eval(Instruction *instr) {
+    auto bb = instr->get_parent();
+    if (instr->is_phi()) {
+        auto res = Range::empty();
+        for (auto [val, pred] :
+             static_cast<PhiInst *>(instr)->get_phi_pairs()) {
+            if (is_trap_block(pred))
+                continue;
+            auto conds = conds_.at(pred);
+            std::pair<Instruction *, bool> cond;
+            if (get_edge_cond(pred, bb, cond))
+                conds.push_back(cond);
+            res = res.join(refine(val, get_range(val), conds));
+        }
+        return res;
+    }
+    if (instr->is_zext())
+        return {0, 1};
+    if (not instr->isBinary() or instr->get_type()->is_float_type())
+        return Range::full();
+
+    auto a = get_range(instr->get_operand(0), bb);
+    auto b = get_range(instr->get_operand(1), bb);
+    if (a.is_empty() or b.is_empty())
+        return Range::empty();
+    switch (instr->get_instr_type()) {
+    case Instruction::add:
+        return clamp(a.lo + b.lo, a.hi + b.hi);
+    case Instruction::sub:
+        return clamp(a.lo - b.hi, a.hi - b.lo);
+    case Instruction::mul:
+    case Instruction::sdiv: {
+        // 除数区间跨过 0 时结果不受限
+        if (instr->is_div() and b.lo <= 0 and b.hi >= 0)
+            return Range::full();
+        std::vector<int64_t> corners;
+        for (auto x : {a.lo, a.hi}) {
+            for (auto y : {b.lo, b.hi})
+                corners.push_back(instr->is_div() ? x / y : x * y);
+        }
+        return clamp(*std::min_element(corners.begin(), corners.end()),
+                     *std::max_element(corners.begin(), corners.end()));
+    }
+    default:
+        return Range::full();
+    }
+}
+
+Range RangeAnalysis::widen(const Range &old_range, const Range &new_range) {
+    if (old_range.is_empty())
+        return new_range;
+    auto res = new_range;
+    if (new_range.lo < old_range.lo)
+        res.lo = *std::prev(std::upper_bound(thresholds_.begin(),
+                                             thresholds_.end(), new_range.lo));
+    if (new_range.hi > old_range.hi)
+        res.hi = *std::lower_bound(thresholds_.begin(), thresholds_.end(),
+                                   new_range.hi);
+    return res;
+}
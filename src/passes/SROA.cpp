@@ -0,0 +1,92 @@
+#include "SROA.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <vector>
+
+void SROA::run() {
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        func_ = &f;
+        std::vector<AllocaInst *> candidates;
+        for (auto &bb : func_->get_basic_blocks()) {
+            for (auto &instr : bb.get_instructions()) {
+                if (not instr.is_alloca())
+                    continue;
+                auto alloca = static_cast<AllocaInst *>(&instr);
+                if (alloca->get_alloca_type()->is_array_type() and
+                    can_split(alloca))
+                    candidates.push_back(alloca);
+            }
+        }
+        for (auto alloca : candidates) {
+            split(alloca);
+        }
+    }
+    LOG_INFO << "sroa split " << split_count_ << " arrays";
+}
+
+int SROA::get_const_index(GetElementPtrInst *gep) {
+    if (gep->get_num_operand() != 3)
+        return -1;
+    auto first = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+    auto idx = dynamic_cast<ConstantInt *>(gep->get_operand(2));
+    if (first == nullptr or first->get_value() != 0 or idx == nullptr)
+        return -1;
+    return idx->get_value();
+}
+
+bool SROA::can_split(AllocaInst *alloca) {
+    auto arr_ty = static_cast<ArrayType *>(alloca->get_alloca_type());
+    if (arr_ty->get_element_type()->is_array_type())
+        return false;
+    int num = arr_ty->get_num_of_elements();
+    for (auto &use : alloca->get_use_list()) {
+        auto gep = dynamic_cast<GetElementPtrInst *>(use.val_);
+        if (gep == nullptr or use.arg_no_ != 0)
+            return false;
+        // 越界的常量下标保持原样，运行时行为由原数组决定
+        auto idx = get_const_index(gep);
+        if (idx < 0 or idx >= num)
+            return false;
+        // 元素地址只能被 load/store 直接访问，传入函数调用即视为逃逸
+        for (auto &gep_use : gep->get_use_list()) {
+            auto user = dynamic_cast<Instruction *>(gep_use.val_);
+            if (user == nullptr)
+                return false;
+            if (user->is_load())
+                continue;
+            if (user->is_store() and gep_use.arg_no_ == 1)
+                continue;
+            return false;
+        }
+    }
+    return true;
+}
+
+void SROA::split(AllocaInst *alloca) {
+    auto entry = func_->get_entry_block();
+    auto elem_ty =
+        static_cast<ArrayType *>(alloca->get_alloca_type())->get_element_type();
+    std::map<int, AllocaInst *> elem_alloca;
+    std::vector<GetElementPtrInst *> geps;
+    for (auto &use : alloca->get_use_list()) {
+        geps.push_back(static_cast<GetElementPtrInst *>(use.val_));
+    }
+    for (auto gep : geps) {
+        auto idx = get_const_index(gep);
+        if (elem_alloca.find(idx) == elem_alloca.end()) {
+            auto new_alloca = AllocaInst::create_alloca(elem_ty, nullptr);
+            new_alloca->set_parent(entry);
+            entry->add_instr_begin(new_alloca);
+            elem_alloca[idx] = new_alloca;
+        }
+        gep->replace_all_use_with(elem_alloca[idx]);
+        gep->get_parent()->erase_instr(gep);
+    }
+    alloca->get_parent()->erase_instr(alloca);
+    split_count_++;
+}
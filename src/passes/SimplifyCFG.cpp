@@ -0,0 +1,210 @@
+#include "SimplifyCFG.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+#include <vector>
+
+void SimplifyCFG::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        func_ = &func;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            changed |= fold_branches();
+            changed |= func_->remove_unreachable_bbs();
+            changed |= merge_blocks();
+            changed |= forward_empty_blocks();
+        }
+    }
+    LOG_INFO << "simplify cfg folded " << folded_count_ << " branches, merged "
+             << merged_count_ << " blocks, forwarded " << forwarded_count_
+             << " blocks";
+}
+
+void SimplifyCFG::replace_with_br(BasicBlock *bb, BasicBlock *target) {
+    auto br = static_cast<BranchInst *>(bb->get_terminator());
+    for (unsigned i = 1; i < 3; i++) {
+        auto succ = static_cast<BasicBlock *>(br->get_operand(i));
+        if (succ == target)
+            continue;
+        for (auto &instr : succ->get_instructions()) {
+            if (not instr.is_phi())
+                break;
+            static_cast<PhiInst *>(&instr)->remove_phi_operand(bb);
+        }
+    }
+    bb->erase_instr(br);
+    BranchInst::create_br(target, bb);
+}
+
+bool SimplifyCFG::fold_branches() {
+    bool changed = false;
+    for (auto &bb : func_->get_basic_blocks()) {
+        auto term = bb.get_terminator();
+        if (not term->is_br())
+            continue;
+        auto br = static_cast<BranchInst *>(term);
+        if (not br->is_cond_br())
+            continue;
+        auto true_bb = static_cast<BasicBlock *>(br->get_operand(1));
+        auto false_bb = static_cast<BasicBlock *>(br->get_operand(2));
+        BasicBlock *target = nullptr;
+        if (true_bb == false_bb)
+            target = true_bb;
+        else if (auto cond = dynamic_cast<ConstantInt *>(br->get_operand(0)))
+            target = cond->get_value() ? true_bb : false_bb;
+        if (target == nullptr)
+            continue;
+        replace_with_br(&bb, target);
+        folded_count_++;
+        changed = true;
+    }
+    return changed;
+}
+
+void SimplifyCFG::merge_into(BasicBlock *bb, BasicBlock *pre) {
+    // 只有一个前驱时 phi 至多一个输入，没有输入即为 undef，取零
+    std::vector<Instruction *> phis;
+    for (auto &instr : bb->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        phis.push_back(&instr);
+    }
+    for (auto phi : phis) {
+        Value *val = nullptr;
+        if (phi->get_num_operand() > 0)
+            val = phi->get_operand(0);
+        else if (phi->get_type()->is_float_type())
+            val = ConstantFP::get(0.0f, m_);
+        else
+            val = ConstantInt::get(0, m_);
+        phi->replace_all_use_with(val);
+        bb->erase_instr(phi);
+    }
+
+    pre->erase_instr(pre->get_terminator());
+    std::vector<Instruction *> instrs;
+    for (auto &instr : bb->get_instructions())
+        instrs.push_back(&instr);
+    for (auto instr : instrs) {
+        bb->remove_instr(instr);
+        instr->set_parent(pre);
+        pre->add_instruction(instr);
+    }
+
+    // 后继的前驱及其中 phi 的来源块都改为 pre
+    for (auto succ : bb->get_succ_basic_blocks()) {
+        auto &pres = succ->get_pre_basic_blocks();
+        std::replace(pres.begin(), pres.end(), bb, pre);
+        pre->add_succ_basic_block(succ);
+    }
+    bb->replace_all_use_with(pre);
+    bb->get_succ_basic_blocks().clear();
+    bb->get_pre_basic_blocks().clear();
+    func_->remove(bb);
+    delete bb;
+}
+
+bool SimplifyCFG::merge_blocks() {
+    bool changed = false;
+    std::vector<BasicBlock *> bbs;
+    for (auto &bb : func_->get_basic_blocks())
+        bbs.push_back(&bb);
+    // 合并只会删除被合并的块，按原顺序遍历时跳过已删除的块
+    std::vector<BasicBlock *> erased;
+    for (auto bb : bbs) {
+        if (std::find(erased.begin(), erased.end(), bb) != erased.end())
+            continue;
+        if (bb == func_->get_entry_block())
+            continue;
+        if (bb->get_pre_basic_blocks().size() != 1)
+            continue;
+        auto pre = bb->get_pre_basic_blocks().front();
+        if (pre == bb or pre->get_succ_basic_blocks().size() != 1)
+            continue;
+        merge_into(bb, pre);
+        erased.push_back(bb);
+        merged_count_++;
+        changed = true;
+    }
+    return changed;
+}
+
+bool SimplifyCFG::can_forward(BasicBlock *bb) {
+    if (bb == func_->get_entry_block() or bb->get_num_of_instr() != 1)
+        return false;
+    auto term = bb->get_terminator();
+    if (not term->is_br())
+        return false;
+    auto br = static_cast<BranchInst *>(term);
+    if (br->is_cond_br())
+        return false;
+    auto succ = static_cast<BasicBlock *>(br->get_operand(0));
+    if (succ == bb)
+        return false;
+    if (succ->empty() or not succ->get_instructions().front().is_phi())
+        return true;
+    // 后继有 phi 时，前驱不能已经是后继的前驱，否则 phi 无法区分两条边
+    auto &succ_pres = succ->get_pre_basic_blocks();
+    for (auto pre : bb->get_pre_basic_blocks()) {
+        if (std::find(succ_pres.begin(), succ_pres.end(), pre) !=
+            succ_pres.end())
+            return false;
+    }
+    return true;
+}
+
+void SimplifyCFG::forward(BasicBlock *bb) {
+    auto succ = static_cast<BasicBlock *>(bb->get_terminator()->get_operand(0));
+    std::vector<BasicBlock *> pres(bb->get_pre_basic_blocks().begin(),
+                                   bb->get_pre_basic_blocks().end());
+    pres.erase(std::unique(pres.begin(), pres.end()), pres.end());
+
+    for (auto &instr : succ->get_instructions()) {
+        if (not instr.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&instr);
+        Value *val = nullptr;
+        for (auto [v, from] : phi->get_phi_pairs()) {
+            if (from == bb)
+                val = v;
+        }
+        // 从 bb 进入时为 undef，新的前驱也缺省为 undef
+        if (val == nullptr)
+            continue;
+        phi->remove_phi_operand(bb);
+        for (auto pre : pres)
+            phi->add_phi_pair_operand(val, pre);
+    }
+
+    for (auto pre : pres) {
+        auto term = pre->get_terminator();
+        for (unsigned i = 0; i < term->get_num_operand(); i++) {
+            if (term->get_operand(i) != bb)
+                continue;
+            term->set_operand(i, succ);
+            pre->remove_succ_basic_block(bb);
+            pre->add_succ_basic_block(succ);
+            succ->add_pre_basic_block(pre);
+        }
+    }
+    bb->get_pre_basic_blocks().clear();
+}
+
+bool SimplifyCFG::forward_empty_blocks() {
+    bool changed = false;
+    for (auto &bb : func_->get_basic_blocks()) {
+        if (bb.get_pre_basic_blocks().empty() or not can_forward(&bb))
+            continue;
+        forward(&bb);
+        forwarded_count_++;
+        changed = true;
+    }
+    // 被旁路的空块已不可达，交由下一轮删除
+    return changed;
+}
@@ -0,0 +1,119 @@
+#include "StrengthReduction.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <tuple>
+#include <vector>
+
+void StrengthReduction::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration())
+            continue;
+        loop_simplify_->run_on_func(&func);
+        loop_info_->run_on_func(&func);
+        for (auto loop : loop_info_->get_loops_inner_first(&func)) {
+            ivs_->run_on_loop(loop);
+            reduce_multiplies(loop);
+            // 削弱后新增的归纳变量可能与已有的重复
+            ivs_->run_on_loop(loop);
+            merge_redundant_ivs(loop);
+        }
+    }
+    LOG_INFO << "strength reduction reduced " << reduced_count_
+             << " multiplies, merged " << merged_count_
+             << " induction variables";
+}
+
+Value *StrengthReduction::emit_mul(Value *lhs, int rhs, BasicBlock *bb) {
+    if (auto lhs_const = dynamic_cast<ConstantInt *>(lhs)) {
+        return ConstantInt::get(
+            static_cast<int>(static_cast<unsigned>(lhs_const->get_value()) *
+                             static_cast<unsigned>(rhs)),
+            m_);
+    }
+    if (rhs == 1)
+        return lhs;
+    auto term = bb->get_terminator();
+    auto res = IBinaryInst::create_mul(lhs, ConstantInt::get(rhs, m_), bb);
+    bb->remove_instr(res);
+    bb->insert_before(term->getIterator(), res);
+    return res;
+}
+
+Value *StrengthReduction::emit_add(Value *lhs, Value *rhs, BasicBlock *bb) {
+    if (rhs == nullptr)
+        return lhs;
+    auto lhs_const = dynamic_cast<ConstantInt *>(lhs);
+    auto rhs_const = dynamic_cast<ConstantInt *>(rhs);
+    if (lhs_const != nullptr and rhs_const != nullptr) {
+        return ConstantInt::get(
+            static_cast<int>(static_cast<unsigned>(lhs_const->get_value()) +
+                             static_cast<unsigned>(rhs_const->get_value())),
+            m_);
+    }
+    auto term = bb->get_terminator();
+    auto res = IBinaryInst::create_add(lhs, rhs, bb);
+    bb->remove_instr(res);
+    bb->insert_before(term->getIterator(), res);
+    return res;
+}
+
+void StrengthReduction::reduce_multiplies(Loop *loop) {
+    auto preheader = loop->get_preheader();
+    auto latch = loop->get_latch();
+    auto header = loop->get_header();
+    auto &affine_ivs = ivs_->get_affine_ivs(loop);
+    std::map<PhiInst *, const InductionVars::BasicIV *> basic_of;
+    for (auto &basic : ivs_->get_basic_ivs(loop))
+        basic_of[basic.phi] = &basic;
+
+    // 相同仿射形式的乘法共用一个新的归纳变量
+    std::map<std::tuple<PhiInst *, int, Value *>, PhiInst *> reduced;
+    std::vector<std::pair<Instruction *, InductionVars::AffineIV>> muls;
+    for (auto &[val, iv] : affine_ivs) {
+        auto instr = static_cast<Instruction *>(val);
+        if (instr->is_mul() and iv.scale != 0 and iv.scale != 1)
+            muls.push_back({instr, iv});
+    }
+    for (auto [mul, iv] : muls) {
+        auto key = std::make_tuple(iv.basic, iv.scale, iv.offset);
+        auto it = reduced.find(key);
+        if (it == reduced.end()) {
+            auto basic = basic_of.at(iv.basic);
+            auto init = emit_add(emit_mul(basic->init, iv.scale, preheader),
+                                 iv.offset, preheader);
+            auto step = emit_mul(basic->step, iv.scale, preheader);
+            auto phi = PhiInst::create_phi(mul->get_type(), header);
+            header->add_instr_begin(phi);
+            auto next = IBinaryInst::create_add(phi, step, latch);
+            latch->remove_instr(next);
+            latch->insert_before(latch->get_terminator()->getIterator(), next);
+            phi->add_phi_pair_operand(init, preheader);
+            phi->add_phi_pair_operand(next, latch);
+            it = reduced.insert({key, phi}).first;
+        }
+        mul->replace_all_use_with(it->second);
+        reduced_count_++;
+    }
+}
+
+void StrengthReduction::merge_redundant_ivs(Loop *loop) {
+    auto &basic_ivs = ivs_->get_basic_ivs(loop);
+    std::vector<bool> merged(basic_ivs.size(), false);
+    for (unsigned i = 0; i < basic_ivs.size(); i++) {
+        if (merged[i])
+            continue;
+        for (unsigned j = i + 1; j < basic_ivs.size(); j++) {
+            auto &keep = basic_ivs[i];
+            auto &dup = basic_ivs[j];
+            if (merged[j] or keep.init != dup.init or keep.step != dup.step)
+                continue;
+            // dup 的递增改为基于 keep.phi 计算，dup.phi 随之成为死代码
+            dup.phi->replace_all_use_with(keep.phi);
+            merged[j] = true;
+            merged_count_++;
+        }
+    }
+}
@@ -0,0 +1,196 @@
+#include "TailRecursionElim.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "Module.hpp"
+#include "logging.hpp"
+
+#include <map>
+
+void TailRecursionElim::run() {
+    for (auto &func : m_->get_functions()) {
+        if (func.is_declaration() or has_escaping_alloca(&func))
+            continue;
+        std::vector<TailCall> tails;
+        Instruction::OpID acc_kind = Instruction::ret;
+        for (auto &bb : func.get_basic_blocks()) {
+            TailCall tail;
+            if (not match_tail_call(&bb, &func, tail))
+                continue;
+            // 所有累加都必须是同一种运算
+            if (tail.acc_op != nullptr) {
+                if (acc_kind == Instruction::ret)
+                    acc_kind = tail.acc_op->get_instr_type();
+                if (tail.acc_op->get_instr_type() != acc_kind)
+                    continue;
+            }
+            tails.push_back(tail);
+        }
+        if (tails.empty())
+            continue;
+        eliminate(&func, tails);
+        eliminated_count_ += tails.size();
+    }
+    LOG_INFO << "tail recursion elimination removed " << eliminated_count_
+             << " calls";
+}
+
+bool TailRecursionElim::has_escaping_alloca(Function *func) {
+    for (auto &instr : func->get_entry_block()->get_instructions()) {
+        if (not instr.is_alloca())
+            continue;
+        std::vector<Value *> work_list{&instr};
+        while (not work_list.empty()) {
+            auto ptr = work_list.back();
+            work_list.pop_back();
+            for (auto &use : ptr->get_use_list()) {
+                auto user = dynamic_cast<Instruction *>(use.val_);
+                if (user->is_gep())
+                    work_list.push_back(user);
+                else if (user->is_call() or
+                         (user->is_store() and use.arg_no_ == 0))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool TailRecursionElim::match_tail_call(BasicBlock *bb, Function *func,
+                                        TailCall &tail) {
+    auto &instrs = bb->get_instructions();
+    auto term = bb->get_terminator();
+    if (not term->is_ret() or &instrs.front() == term)
+        return false;
+    auto ret = static_cast<ReturnInst *>(term);
+    auto prev = &*std::prev(ret->getIterator());
+
+    tail.acc_op = nullptr;
+    if (prev->is_call()) {
+        // ret f(...) 或 f(...); ret void
+        if (prev->get_operand(0) != func)
+            return false;
+        if (not ret->is_void_ret() and ret->get_operand(0) != prev)
+            return false;
+        if (ret->is_void_ret() and not prev->get_use_list().empty())
+            return false;
+        tail.call = static_cast<CallInst *>(prev);
+        return true;
+    }
+
+    // ret x op f(...)，累加运算只接受满足结合律的整数加法和乘法
+    if (not prev->is_add() and not prev->is_mul())
+        return false;
+    if (ret->is_void_ret() or ret->get_operand(0) != prev or
+        prev->get_use_list().size() != 1 or &instrs.front() == prev)
+        return false;
+    auto call = &*std::prev(prev->getIterator());
+    if (not call->is_call() or call->get_operand(0) != func or
+        call->get_use_list().size() != 1)
+        return false;
+    Value *other = nullptr;
+    if (prev->get_operand(0) == call)
+        other = prev->get_operand(1);
+    else if (prev->get_operand(1) == call)
+        other = prev->get_operand(0);
+    if (other == nullptr or other == call)
+        return false;
+    tail.call = static_cast<CallInst *>(call);
+    tail.acc_op = prev;
+    return true;
+}
+
+void TailRecursionElim::eliminate(Function *func, std::vector<TailCall> &tails) {
+    auto m = func->get_parent();
+    auto header = func->get_entry_block();
+
+    // 新的入口块只保留局部变量的分配，并跳到原入口（循环头）
+    auto entry = BasicBlock::create(m, "", func);
+    func->get_basic_blocks().remove(entry);
+    func->get_basic_blocks().push_front(entry);
+    std::vector<Instruction *> allocas;
+    for (auto &instr : header->get_instructions()) {
+        if (instr.is_alloca())
+            allocas.push_back(&instr);
+    }
+    for (auto alloca : allocas) {
+        header->remove_instr(alloca);
+        alloca->set_parent(entry);
+        entry->add_instruction(alloca);
+    }
+    BranchInst::create_br(header, entry);
+
+    // 形参改由循环头中的 phi 给出
+    std::vector<PhiInst *> arg_phis;
+    for (auto &arg : func->get_args()) {
+        auto phi = PhiInst::create_phi(arg.get_type(), header, {&arg}, {entry});
+        arg.replace_use_with_if(phi, [phi](Use *use) { return use->val_ != phi; });
+        arg_phis.push_back(phi);
+    }
+
+    // 累加器
+    PhiInst *acc = nullptr;
+    Instruction::OpID acc_kind = Instruction::ret;
+    for (auto &tail : tails) {
+        if (tail.acc_op != nullptr)
+            acc_kind = tail.acc_op->get_instr_type();
+    }
+    if (acc_kind != Instruction::ret) {
+        Value *identity = ConstantInt::get(acc_kind == Instruction::add ? 0 : 1, m);
+        acc = PhiInst::create_phi(func->get_return_type(), header, {identity},
+                                  {entry});
+    }
+
+    // 非递归的返回值与累加器运算后返回
+    std::vector<ReturnInst *> rets;
+    for (auto &bb : func->get_basic_blocks()) {
+        auto term = bb.get_terminator();
+        if (term->is_ret())
+            rets.push_back(static_cast<ReturnInst *>(term));
+    }
+    std::map<BasicBlock *, TailCall *> tail_of;
+    for (auto &tail : tails)
+        tail_of[tail.call->get_parent()] = &tail;
+    if (acc != nullptr) {
+        for (auto ret : rets) {
+            if (tail_of.count(ret->get_parent()))
+                continue;
+            auto bb = ret->get_parent();
+            auto val = ret->get_operand(0);
+            auto res = acc_kind == Instruction::add
+                           ? IBinaryInst::create_add(acc, val, bb)
+                           : IBinaryInst::create_mul(acc, val, bb);
+            bb->remove_instr(res);
+            bb->insert_before(ret->getIterator(), res);
+            ret->set_operand(0, res);
+        }
+    }
+
+    // 尾调用改为更新 phi 并跳回循环头
+    for (auto &tail : tails) {
+        auto bb = tail.call->get_parent();
+        bb->erase_instr(bb->get_terminator());
+        for (unsigned i = 0; i < arg_phis.size(); i++)
+            arg_phis[i]->add_phi_pair_operand(tail.call->get_operand(i + 1), bb);
+        if (acc != nullptr) {
+            Value *next = acc;
+            if (tail.acc_op != nullptr) {
+                // 形参已被替换为 phi，需重新读取操作数
+                auto val = tail.acc_op->get_operand(
+                    tail.acc_op->get_operand(0) == tail.call ? 1 : 0);
+                next = acc_kind == Instruction::add
+                           ? IBinaryInst::create_add(acc, val, bb)
+                           : IBinaryInst::create_mul(acc, val, bb);
+                bb->erase_instr(tail.acc_op);
+            }
+            acc->add_phi_pair_operand(next, bb);
+        }
+        bb->erase_instr(tail.call);
+        BranchInst::create_br(header, bb);
+    }
+
+    if (acc != nullptr)
+        header->add_instr_begin(acc);
+    for (auto it = arg_phis.rbegin(); it != arg_phis.rend(); ++it)
+        header->add_instr_begin(*it);
+}